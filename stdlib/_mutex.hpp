@@ -2,16 +2,63 @@
 #pragma once
 
 #include "internal/sync_cond.hpp"
+#include "internal/sync_futex.hpp"
 #include "internal/sync_mutex.hpp"
 
+#include <cstdint>
 #include <utility>
 
 namespace sync {
 
 // mutex types
+#if SYNC_FUTEX
+
+// single futex word: 0 unlocked, 1 locked, 2 locked with (possible) waiters
 class mutex {
 public:
-    /*constexpr*/ mutex() {
+    constexpr mutex() noexcept = default;
+
+    mutex(mutex const&) = delete;
+    mutex& operator=(mutex const&) = delete;
+
+    void lock() {
+        std::uint32_t c{0};
+        if (!state_.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed))
+            lock_contended(c);
+    }
+
+    bool try_lock() {
+        std::uint32_t c{0};
+        return state_.compare_exchange_strong(c, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (state_.exchange(0, std::memory_order_release) == 2)
+            sync_futex_wake(state_);
+    }
+
+    auto native_handle() {
+        return &state_;
+    }
+
+private:
+    void lock_contended(std::uint32_t c) {
+        if (c != 2)
+            c = state_.exchange(2, std::memory_order_acquire);
+        while (c != 0) {
+            sync_futex_wait(state_, 2);
+            c = state_.exchange(2, std::memory_order_acquire);
+        }
+    }
+
+    sync_futex_t state_{0};
+};
+
+#else
+
+class mutex {
+public:
+    mutex() {
         sync_mutex_init(mtx_);
     }
 
@@ -43,6 +90,8 @@ private:
     sync_mutex_t mtx_;
 };
 
+#endif
+
 // lock types
 struct defer_lock_t { explicit defer_lock_t() = default; };
 struct try_to_lock_t { explicit try_to_lock_t() = default; };
@@ -85,7 +134,10 @@ public:
     // Constructors
     unique_lock() = default;
     
-    unique_lock(unique_lock&&) = default;
+    unique_lock(unique_lock&& other) noexcept
+        : mtx_{std::exchange(other.mtx_, nullptr)}
+        , owns_{std::exchange(other.owns_, false)}
+    {}
 
     unique_lock(mutex_type& m)
         : mtx_{&m}
@@ -127,18 +179,23 @@ public:
     }
 
     // assignment operator
-    unique_lock& operator=(unique_lock&& other) {
+    unique_lock& operator=(unique_lock&& other) noexcept {
+        if (owns_)
+            mtx_->unlock();
         mtx_ = std::exchange(other.mtx_, nullptr);
         owns_ = std::exchange(other.owns_, false);
+        return *this;
     }
 
     // Locking
     void lock() {
-        mtx_->lock();    
+        mtx_->lock();
+        owns_ = true;
     }
 
     bool try_lock() {
-        return mtx_->try_lock();
+        owns_ = mtx_->try_lock();
+        return owns_;
     }
 
     template<class Rep, class Period>
@@ -201,22 +258,44 @@ enum class cv_status {
 // condition variable types
 class condition_variable {
 public:
+#if SYNC_FUTEX
+    constexpr condition_variable() noexcept = default;
+#else
     condition_variable() {
         sync_cond_init(cv_);
     }
+#endif
 
     condition_variable(condition_variable const&) = delete;
 
     void notify_one() noexcept {
+#if SYNC_FUTEX
+        seq_.fetch_add(1, std::memory_order_relaxed);
+        sync_futex_wake(seq_);
+#else
         sync_cond_signal(cv_);
+#endif
     }
 
     void notify_all() noexcept {
+#if SYNC_FUTEX
+        seq_.fetch_add(1, std::memory_order_relaxed);
+        sync_futex_wake_all(seq_);
+#else
         sync_cond_broadcast(cv_);
+#endif
     }
 
     void wait(unique_lock<mutex>& lock) {
+#if SYNC_FUTEX
+        // the sequence is read under the lock, so a notify after the unlock always changes it
+        std::uint32_t const seq{seq_.load(std::memory_order_relaxed)};
+        lock.mutex()->unlock();
+        sync_futex_wait(seq_, seq);
+        lock.mutex()->lock();
+#else
         sync_cond_wait(cv_, *lock.mutex()->native_handle());
+#endif
     }
 
     template<class Predicate>
@@ -230,6 +309,17 @@ public:
                         const std::chrono::duration<Rep, Period>& dur) {
         if (dur <= dur.zero())
             return cv_status::timeout;
+#if SYNC_FUTEX
+        using ns_f = std::chrono::duration<long double, std::nano>;
+        std::chrono::nanoseconds const ns{ns_f{dur} < ns_f{std::chrono::nanoseconds::max()} 
+            ? std::chrono::ceil<std::chrono::nanoseconds>(dur) 
+            : std::chrono::nanoseconds::max()};
+        std::uint32_t const seq{seq_.load(std::memory_order_relaxed)};
+        std::chrono::steady_clock::time_point c_now{std::chrono::steady_clock::now()};
+        lock.mutex()->unlock();
+        (void)sync_futex_wait_for(seq_, seq, ns);
+        lock.mutex()->lock();
+#else
         using sys_tpf = std::chrono::time_point<std::chrono::system_clock, std::chrono::duration<long double, std::nano>>;
         using sys_tpi = std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>;
         sys_tpf max{sys_tpi::max()};
@@ -239,6 +329,7 @@ public:
             sync_cond_timedwait(cv_, *lock.mutex()->native_handle(), s_now + std::chrono::ceil<std::chrono::nanoseconds>(dur));
         else
             sync_cond_timedwait(cv_, *lock.mutex()->native_handle(), sys_tpi::max());
+#endif
         
         return std::chrono::steady_clock::now() - c_now < dur ? cv_status::no_timeout : cv_status::timeout;
     }
@@ -270,11 +361,19 @@ public:
     }    
 
     auto native_handle() {
+#if SYNC_FUTEX
+        return &seq_;
+#else
         return &cv_;
+#endif
     }
 
     private:
+#if SYNC_FUTEX
+        sync_futex_t seq_{0};
+#else
         sync_cond_t cv_;
+#endif
 };
 
 }
\ No newline at end of file
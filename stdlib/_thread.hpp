@@ -3,11 +3,16 @@
 
 #include "internal/sync_thread.hpp"
 
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <string>
+#include <system_error>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace sync {
 
@@ -37,6 +42,46 @@ public:
     using native_handle_type = sync_thread_t;
     using id = sync_thread_id_t;
 
+    // Creation options, set through chained calls:
+    //   sync::thread t{sync::thread::attributes{}.stack_size(64 * 1024).name("io"), fn};
+    class attributes {
+    public:
+        attributes& stack_size(std::size_t bytes) {
+            attr_.stack_size = bytes;
+            return *this;
+        }
+
+        attributes& guard_size(std::size_t bytes) {
+            attr_.guard_size = bytes;
+            return *this;
+        }
+
+        // shown by top, perf and debuggers
+        attributes& name(std::string name) {
+            attr_.name = std::move(name);
+            return *this;
+        }
+
+        attributes& cpus(std::vector<unsigned int> cpus) {
+            attr_.cpus = std::move(cpus);
+            return *this;
+        }
+
+        // real time SCHED_FIFO scheduling, usually needs privileges: without them (EPERM)
+        // or with a priority out of range (EINVAL) the thread constructor throws system_error
+        attributes& fifo_priority(int priority) {
+            attr_.fifo_priority = priority;
+            return *this;
+        }
+
+        sync_thread_attributes const& native() const noexcept {
+            return attr_;
+        }
+
+    private:
+        sync_thread_attributes attr_;
+    };
+
     // Member functions
     thread() noexcept = default;
 
@@ -53,13 +98,14 @@ public:
         return *this;
     }
 
-    template <class Fn, class ...Args>
+    template <class Fn, class ...Args, std::enable_if_t<!std::is_same_v<std::remove_cvref_t<Fn>, attributes>, int> = 0>
     explicit thread(Fn&& f, Args&&... args) {
-        using Tup = std::tuple<std::decay_t<Fn>, std::decay_t<Args>...>;  
-        std::unique_ptr<Tup> ptr{
-            std::make_unique<Tup>(decay_copy(std::forward<Fn>(f)), 
-                                  decay_copy(std::forward<Args>(args))...)};
-        sync_thread_create(handle_, &void_callable<Tup>, static_cast<void*>(ptr.release()));
+        create(nullptr, std::forward<Fn>(f), std::forward<Args>(args)...);
+    }
+
+    template <class Fn, class ...Args>
+    thread(attributes const& attr, Fn&& f, Args&&... args) {
+        create(&attr.native(), std::forward<Fn>(f), std::forward<Args>(args)...);
     }
 
     ~thread() {
@@ -101,6 +147,20 @@ public:
     }
 
 private:
+    template <class Fn, class ...Args>
+    void create(sync_thread_attributes const* attr, Fn&& f, Args&&... args) {
+        using Tup = std::tuple<std::decay_t<Fn>, std::decay_t<Args>...>;  
+        std::unique_ptr<Tup> ptr{
+            std::make_unique<Tup>(decay_copy(std::forward<Fn>(f)), 
+                                  decay_copy(std::forward<Args>(args))...)};
+        native_handle_type handle{SYNC_NULL_THREAD};
+        if (int const err = sync_thread_create(handle, &void_callable<Tup>, static_cast<void*>(ptr.get()), attr); err != 0)
+            throw std::system_error{err, std::system_category(), "thread creation failed"};
+        // the new thread owns the arguments now
+        (void)ptr.release();
+        handle_ = handle;
+    }
+
     native_handle_type  handle_{SYNC_NULL_THREAD};
 };
 
@@ -109,11 +169,11 @@ inline void swap(thread& x, thread& y) noexcept {
 }
 
 namespace this_thread {
-    void yield() noexcept {
+    inline void yield() noexcept {
         sync_thread_yield();
     }
 
-    thread::id get_id() noexcept {
+    inline thread::id get_id() noexcept {
         return sync_thread_curr_id();
     }
 
@@ -16,3 +16,15 @@
 #else
     #error "Unknown compiler"
 #endif
+
+// futex backed mutex and condition_variable, define SYNC_DISABLE_FUTEX to fall back to pthreads
+#if SYNC_LINUX && !defined(SYNC_DISABLE_FUTEX)
+    #define SYNC_FUTEX 1
+#else
+    #define SYNC_FUTEX 0
+#endif
+
+// padding unit used to keep independently written atomics on separate cache lines
+#ifndef SYNC_CACHE_LINE_SIZE
+    #define SYNC_CACHE_LINE_SIZE 64
+#endif
@@ -0,0 +1,85 @@
+// sync_futex.hpp
+#pragma once
+
+#include "include/assert.hpp"
+#include "include/platform.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+#if SYNC_LINUX
+    #include <errno.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+namespace sync {
+
+// a futex word, waited on and woken by address
+using sync_futex_t = std::atomic<std::uint32_t>;
+
+inline void sync_futex_wait(sync_futex_t&, std::uint32_t);
+inline void sync_futex_wake(sync_futex_t&);
+inline void sync_futex_wake_all(sync_futex_t&);
+
+#if SYNC_FUTEX
+
+inline bool sync_futex_wait_for(sync_futex_t&, std::uint32_t, std::chrono::nanoseconds);
+
+inline long sync_futex(sync_futex_t& f, int op, std::uint32_t val, ::timespec const* ts) {
+    static_assert(sizeof(sync_futex_t) == sizeof(std::uint32_t), "futex word must be 32 bits");
+    return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&f), op, val, ts, nullptr, 0);
+}
+
+// blocks while f == expected, may wake spuriously
+inline void sync_futex_wait(sync_futex_t& f, std::uint32_t expected) {
+    if (sync_futex(f, FUTEX_WAIT_PRIVATE, expected, nullptr) == -1)
+        SYNC_ASSERT(errno == EAGAIN || errno == EINTR, "FUTEX_WAIT failed");
+}
+
+// returns false if the relative timeout expired
+inline bool sync_futex_wait_for(sync_futex_t& f, std::uint32_t expected, std::chrono::nanoseconds ns) {
+    using namespace std::chrono;
+    if (ns <= nanoseconds::zero())
+        return false;
+    seconds const s{duration_cast<seconds>(ns)};
+    ::timespec ts;
+    ts.tv_sec = static_cast<decltype(ts.tv_sec)>(s.count());
+    ts.tv_nsec = static_cast<decltype(ts.tv_nsec)>((ns - s).count());
+    if (sync_futex(f, FUTEX_WAIT_PRIVATE, expected, &ts) == -1) {
+        SYNC_ASSERT(errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT, "FUTEX_WAIT failed");
+        return errno != ETIMEDOUT;
+    }
+    return true;
+}
+
+inline void sync_futex_wake(sync_futex_t& f) {
+    (void)sync_futex(f, FUTEX_WAKE_PRIVATE, 1, nullptr);
+}
+
+inline void sync_futex_wake_all(sync_futex_t& f) {
+    (void)sync_futex(f, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+}
+
+#else
+
+// no native futex, fall back to the standard library's address waiting
+inline void sync_futex_wait(sync_futex_t& f, std::uint32_t expected) {
+    f.wait(expected, std::memory_order_relaxed);
+}
+
+inline void sync_futex_wake(sync_futex_t& f) {
+    f.notify_one();
+}
+
+inline void sync_futex_wake_all(sync_futex_t& f) {
+    f.notify_all();
+}
+
+#endif
+
+} // namespace sync
@@ -0,0 +1,59 @@
+// sync_spin.hpp
+#pragma once
+
+#include "include/platform.hpp"
+#include "sync_thread.hpp"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <immintrin.h>
+    #define SYNC_X86 1
+#elif defined(_M_ARM64) || defined(_M_ARM)
+    #include <intrin.h>
+#endif
+
+namespace sync {
+
+// hint to the cpu that we are busy waiting
+inline void sync_cpu_relax() noexcept {
+#if defined(SYNC_X86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#elif defined(_M_ARM64) || defined(_M_ARM)
+    __yield();
+#endif
+}
+
+// Busy wait backoff: each spin relaxes the cpu twice as long as the previous one,
+// once the spin budget is spent try_spin() fails so the caller can park,
+// and spin_once() yields the thread instead.
+class spin_wait {
+public:
+    static constexpr std::uint32_t max_spins = 7;
+
+    [[nodiscard]]
+    bool try_spin() noexcept {
+        if (count_ >= max_spins)
+            return false;
+        for (std::uint32_t i = 1U << count_; i != 0; --i)
+            sync_cpu_relax();
+        ++count_;
+        return true;
+    }
+
+    void spin_once() noexcept {
+        if (!try_spin())
+            sync_thread_yield();
+    }
+
+    void reset() noexcept {
+        count_ = 0;
+    }
+
+private:
+    std::uint32_t count_{0};
+};
+
+} // namespace sync
@@ -5,100 +5,196 @@
 #include "include/platform.hpp"
 #include "include/types.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 #if SYNC_MAC || SYNC_LINUX
     #include <errno.h>
 #endif
 
+#if SYNC_LINUX
+    #include <sched.h>
+#endif
+
 namespace sync {
 
-void sync_thread_create(sync_thread_t&, void*(*)(void*), void*);
-void sync_thread_join(sync_thread_t&);
-void sync_thread_detach(sync_thread_t&);
-void sync_thread_yield();
-sync_thread_id_t sync_thread_curr_id();
-sync_thread_id_t sync_thread_id(sync_thread_t const&);
-bool sync_thread_id_equal(sync_thread_id_t, sync_thread_id_t);
-void sync_thread_sleep_for(std::chrono::nanoseconds const&);
-bool sync_thread_is_null(sync_thread_t const&);
-static unsigned int sync_thread_getconcurrency() noexcept;
+// creation options of a thread, unset fields keep the platform default
+struct sync_thread_attributes {
+    std::size_t                 stack_size{0};
+    std::optional<std::size_t>  guard_size;
+    std::string                 name;       // at most 15 characters are kept on Linux
+    std::vector<unsigned int>   cpus;
+    std::optional<int>          fifo_priority; // real time SCHED_FIFO at this priority
+};
+
+// returns 0 or the error code of the failed step (errno values, GetLastError on Windows)
+inline int sync_thread_create(sync_thread_t&, void*(*)(void*), void*, sync_thread_attributes const* = nullptr);
+inline void sync_thread_join(sync_thread_t&);
+inline void sync_thread_detach(sync_thread_t&);
+inline void sync_thread_yield();
+inline sync_thread_id_t sync_thread_curr_id();
+inline sync_thread_id_t sync_thread_id(sync_thread_t const&);
+inline bool sync_thread_id_equal(sync_thread_id_t, sync_thread_id_t);
+inline void sync_thread_sleep_for(std::chrono::nanoseconds const&);
+inline bool sync_thread_is_null(sync_thread_t const&);
+inline unsigned int sync_thread_getconcurrency() noexcept;
+inline std::vector<unsigned int> sync_thread_usable_cpus();
 
 #if SYNC_WINDOWS
 
-void sync_thread_create(sync_thread_t& t, void*(*f)(void*), void* args) {
-    t = CreateThread(nullptr, 0, f, args, 0);
+inline int sync_thread_create(sync_thread_t& t, void*(*f)(void*), void* args, sync_thread_attributes const* attr) {
+    t = CreateThread(nullptr, attr != nullptr ? attr->stack_size : 0, f, args, 0);
+    if (t == nullptr)
+        return static_cast<int>(GetLastError());
+    if (attr == nullptr)
+        return 0;
+    if (!attr->name.empty())
+        (void)SetThreadDescription(t, std::wstring(attr->name.begin(), attr->name.end()).c_str());
+    if (!attr->cpus.empty()) {
+        // only the first processor group (cpus 0 to 63) can be addressed
+        DWORD_PTR mask = 0;
+        for (unsigned int cpu : attr->cpus)
+            if (cpu < sizeof(DWORD_PTR) * 8)
+                mask |= DWORD_PTR{1} << cpu;
+        if (mask != 0)
+            (void)SetThreadAffinityMask(t, mask);
+    }
+    if (attr->fifo_priority)
+        (void)SetThreadPriority(t, THREAD_PRIORITY_TIME_CRITICAL);
+    return 0;
 }
 
-void sync_thread_join(sync_thread_t& t) {
+inline void sync_thread_join(sync_thread_t& t) {
     SYNC_ASSERT(WaitForSingleObject(t, INFINITE) != WAIT_FAILED, "WaitForSingleObject failed");
     SYNC_WINDOWS_ASSERT(CloseHandle(t), "CloseHandle for joined thread failed");
 }
 
-void sync_thread_detach(sync_thread_t&) {
+inline void sync_thread_detach(sync_thread_t&) {
     SYNC_WINDOWS_ASSERT(CloseHandle(t), "CloseHandle for detached thread failed");
 }
 
-void sync_thread_yield() {
+inline void sync_thread_yield() {
     (void)SwitchToThread();
 }
-sync_thread_id_t sync_thread_curr_id() {
+inline sync_thread_id_t sync_thread_curr_id() {
     return GetCurrentThreadId();
 }
-sync_thread_id_t sync_thread_id(sync_thread_t const& t) {
+inline sync_thread_id_t sync_thread_id(sync_thread_t const& t) {
     return GetThreadId(t);
 }
 
-bool sync_thread_id_equal(sync_thread_id_t a, sync_thread_id_t b) {
+inline bool sync_thread_id_equal(sync_thread_id_t a, sync_thread_id_t b) {
     return a == b;
 }
 
-void sync_thread_sleep_for(std::chrono::nanoseconds const& ns) {
+inline void sync_thread_sleep_for(std::chrono::nanoseconds const& ns) {
     Sleep(static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(ns).count()));
 }
 
-bool sync_thread_is_null(sync_thread_t const& t) {
+inline bool sync_thread_is_null(sync_thread_t const& t) {
     return t == INVALID_HANDLE_VALUE;
 }
 
-static unsigned int sync_thread_getconcurrency() noexcept {
+inline unsigned int sync_thread_getconcurrency() noexcept {
     SYSTEM_INFO sysinfo;
     GetSystemInfo(&sysinfo);
     return static_cast<unsigned int>(sysinfo.dwNumberOfProcessors);
 }
 
+inline std::vector<unsigned int> sync_thread_usable_cpus() {
+    std::vector<unsigned int> cpus;
+    DWORD_PTR process = 0;
+    DWORD_PTR system = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system))
+        for (unsigned int cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+            if (process & (DWORD_PTR{1} << cpu))
+                cpus.push_back(cpu);
+    return cpus;
+}
+
 #elif SYNC_MAC || SYNC_LINUX
 
-void sync_thread_create(sync_thread_t& t, void*(*f)(void*), void* args) {
-    SYNC_POSIX_ASSERT(pthread_create(&t, nullptr, f, args), "pthread_create failed");
+inline int sync_thread_create(sync_thread_t& t, void*(*f)(void*), void* args, sync_thread_attributes const* attr) {
+    if (attr == nullptr)
+        return pthread_create(&t, nullptr, f, args);
+
+    pthread_attr_t pattr;
+    if (int const err = pthread_attr_init(&pattr); err != 0)
+        return err;
+    int err = 0;
+    if (attr->stack_size != 0)
+        err = pthread_attr_setstacksize(&pattr, attr->stack_size);
+    if (err == 0 && attr->guard_size)
+        err = pthread_attr_setguardsize(&pattr, *attr->guard_size);
+#if SYNC_LINUX
+    if (!attr->cpus.empty()) {
+        // pthread_create fails for cpus outside the process affinity (taskset, cpusets),
+        // those are dropped and the thread is left unpinned if none remains
+        cpu_set_t allowed;
+        bool const known = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (unsigned int cpu : attr->cpus)
+            if (cpu < CPU_SETSIZE && (!known || CPU_ISSET(cpu, &allowed)))
+                CPU_SET(cpu, &set);
+        if (CPU_COUNT(&set) != 0)
+            (void)pthread_attr_setaffinity_np(&pattr, sizeof(set), &set);
+    }
+#endif
+    if (err == 0 && attr->fifo_priority) {
+        sched_param param{};
+        param.sched_priority = *attr->fifo_priority;
+        err = pthread_attr_setinheritsched(&pattr, PTHREAD_EXPLICIT_SCHED);
+        if (err == 0)
+            err = pthread_attr_setschedpolicy(&pattr, SCHED_FIFO);
+        if (err == 0)
+            err = pthread_attr_setschedparam(&pattr, &param);
+    }
+    // EPERM here when SCHED_FIFO is asked for without CAP_SYS_NICE
+    if (err == 0)
+        err = pthread_create(&t, &pattr, f, args);
+    (void)pthread_attr_destroy(&pattr);
+#if SYNC_LINUX
+    // macOS can only name the calling thread
+    if (err == 0 && !attr->name.empty())
+        (void)pthread_setname_np(t, attr->name.substr(0, 15).c_str());
+#endif
+    return err;
 }
 
-void sync_thread_join(sync_thread_t& t) {
+inline void sync_thread_join(sync_thread_t& t) {
     SYNC_POSIX_ASSERT(pthread_join(t, nullptr), "pthread_join failed");
     t = SYNC_NULL_THREAD;
 }
 
-void sync_thread_detach(sync_thread_t& t) {
+inline void sync_thread_detach(sync_thread_t& t) {
     SYNC_POSIX_ASSERT(pthread_detach(t), "pthread_detach failed");
 }
 
-void sync_thread_yield() {
+inline void sync_thread_yield() {
     SYNC_POSIX_ASSERT(sched_yield(), "sched_yield failed");
 }
 
-sync_thread_id_t sync_thread_curr_id() {
+inline sync_thread_id_t sync_thread_curr_id() {
     return pthread_self();
 }
 
-sync_thread_id_t sync_thread_id(sync_thread_t const& t) {
+inline sync_thread_id_t sync_thread_id(sync_thread_t const& t) {
     return t;
 }
 
-bool sync_thread_id_equal(sync_thread_id_t t1, sync_thread_id_t t2) {
+inline bool sync_thread_id_equal(sync_thread_id_t t1, sync_thread_id_t t2) {
     return pthread_equal(t1, t2);
 }
 
-void sync_thread_sleep_for(std::chrono::nanoseconds const& ns) {
+inline void sync_thread_sleep_for(std::chrono::nanoseconds const& ns) {
    std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>(ns);
    ::timespec ts;
    using ts_sec = decltype(ts.tv_sec);
@@ -116,12 +212,75 @@ void sync_thread_sleep_for(std::chrono::nanoseconds const& ns) {
    while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
 }
 
-bool sync_thread_is_null(sync_thread_t const& t) {
+inline bool sync_thread_is_null(sync_thread_t const& t) {
     return t == 0;
 }
 
-static unsigned int sync_thread_getconcurrency() noexcept {
-    return static_cast<unsigned int>(pthread_getconcurrency());
+#if SYNC_LINUX
+
+// whole cpus granted by the cgroup v2 cpu.max quota of this process, 0 if unlimited
+static unsigned int sync_cgroup_cpu_limit() noexcept {
+    char path[512] = "/sys/fs/cgroup";
+    if (std::FILE* f = std::fopen("/proc/self/cgroup", "r")) {
+        char line[400];
+        while (std::fgets(line, sizeof(line), f) != nullptr)
+            if (line[0] == '0' && line[1] == ':' && line[2] == ':') {
+                line[std::strcspn(line, "\n")] = '\0';
+                std::snprintf(path, sizeof(path), "/sys/fs/cgroup%s", line + 3);
+                break;
+            }
+        std::fclose(f);
+    }
+    std::string file = std::string{path} + "/cpu.max";
+    std::FILE* f = std::fopen(file.c_str(), "r");
+    if (f == nullptr)
+        f = std::fopen("/sys/fs/cgroup/cpu.max", "r");
+    if (f == nullptr)
+        return 0;
+    long long quota = 0;
+    long long period = 0;
+    int const read = std::fscanf(f, "%lld %lld", &quota, &period);
+    std::fclose(f);
+    if (read != 2 || quota <= 0 || period <= 0) // "max" fails the first conversion
+        return 0;
+    return static_cast<unsigned int>(std::max(1LL, (quota + period - 1) / period));
+}
+
+#endif
+
+// cpus this process may actually run on: the affinity mask, capped by the cgroup quota.
+// Worked out on the first call only, rwlock and pool constructors ask for it on hot paths
+// and the cgroup files are not cheap to parse.
+inline unsigned int sync_thread_getconcurrency() noexcept {
+#if SYNC_LINUX
+    static unsigned int const concurrency = [] {
+        unsigned int count = 0;
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            count = static_cast<unsigned int>(CPU_COUNT(&set));
+        if (count == 0)
+            count = std::thread::hardware_concurrency();
+        if (unsigned int const limit = sync_cgroup_cpu_limit(); limit != 0)
+            count = std::min(count, limit);
+        return std::max(1U, count);
+    }();
+    return concurrency;
+#else
+    return std::max(1U, std::thread::hardware_concurrency());
+#endif
+}
+
+// the cpus of the process affinity mask, empty where it cannot be queried (macOS)
+inline std::vector<unsigned int> sync_thread_usable_cpus() {
+    std::vector<unsigned int> cpus;
+#if SYNC_LINUX
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+#endif
+    return cpus;
 }
 
 #endif
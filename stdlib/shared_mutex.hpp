@@ -2,9 +2,14 @@
 #pragma once
 
 #include "condition_variable.hpp"
-#include "include/assert.hpp"
+#include "internal/include/assert.hpp"
 #include "mutex.hpp"
 
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <utility>
+
 namespace sync {
 
 struct shared_mutex_base {
@@ -13,10 +18,10 @@ struct shared_mutex_base {
     condition_variable  gate2_;
     unsigned            state_{0};
 
-    static constexpr unsigned write_entered_ = 1U << (sizeof(unsigned)*__CHAR_BIT__ - 1);
+    static constexpr unsigned write_entered_ = 1U << (sizeof(unsigned)*CHAR_BIT - 1);
     static constexpr unsigned n_readers_ = ~write_entered_;
 
-    shared_mutex_base();
+    shared_mutex_base() = default;
     ~shared_mutex_base() = default;
 
     shared_mutex_base(shared_mutex_base const&) = delete;
@@ -51,7 +56,7 @@ struct shared_mutex_base {
     void lock_shared() {
         unique_lock lock{mtx_};
         while ((state_ & write_entered_) || (state_ & n_readers_) == n_readers_)
-            gate1_.wait;
+            gate1_.wait(lock);
         unsigned readers = (state_ & n_readers_) + 1;
         state_ &= ~n_readers_;
         state_ |= readers;
@@ -100,7 +105,7 @@ public:
     void unlock() { base_.unlock(); }
 
     void lock_shared() { base_.lock_shared(); }
-    bool try_lock_shared() { base_.try_lock_shared(); }
+    bool try_lock_shared() { return base_.try_lock_shared(); }
     void unlock_shared() { base_.unlock_shared(); }
 
     // auto native_handle();
@@ -109,14 +114,14 @@ public:
 class shared_timed_mutex {
     shared_mutex_base base_;
 public:
-    shared_timed_mutex();
+    shared_timed_mutex() = default;
     ~shared_timed_mutex() = default;
 
     shared_timed_mutex(const shared_timed_mutex&) = delete;
     shared_timed_mutex& operator=(const shared_timed_mutex&) = delete;
 
-    void lock();
-    bool try_lock();
+    void lock() { base_.lock(); }
+    bool try_lock() { return base_.try_lock(); }
     template <class Rep, class Period>
     bool try_lock_for(std::chrono::duration<Rep, Period>const& rel_time) {
             return try_lock_until(std::chrono::steady_clock::now() + rel_time);
@@ -124,18 +129,18 @@ public:
     
     template <class Clock, class Duration>
     bool try_lock_until(const std::chrono::time_point<Clock, Duration>& abs_time);
-    void unlock();
+    void unlock() { base_.unlock(); }
 
-    void lock_shared();
-    bool try_lock_shared();
+    void lock_shared() { base_.lock_shared(); }
+    bool try_lock_shared() { return base_.try_lock_shared(); }
     template <class Rep, class Period>
     bool try_lock_shared_for(std::chrono::duration<Rep, Period> const& rel_time) {
-            return try_lock_shared_until(chrono::steady_clock::now() + rel_time);
+            return try_lock_shared_until(std::chrono::steady_clock::now() + rel_time);
     }
     
     template <class Clock, class Duration>
     bool try_lock_shared_until(std::chrono::time_point<Clock, Duration> const& abs_time);
-    void unlock_shared();
+    void unlock_shared() { base_.unlock_shared(); }
 };
 
 template <class Clock, class Duration>
@@ -168,7 +173,7 @@ bool shared_timed_mutex::try_lock_until(std::chrono::time_point<Clock, Duration>
 
 template <class Clock, class Duration>
 bool shared_timed_mutex::try_lock_shared_until(std::chrono::time_point<Clock, Duration> const& abs_time) {
-    unique_lock<mutex> lock{base_.mtx_};
+    unique_lock lock{base_.mtx_};
     if ((base_.state_ & base_.write_entered_) || (base_.state_ & base_.n_readers_) == base_.n_readers_) {
         for (;;) {
             cv_status status{base_.gate1_.wait_until(lock, abs_time)};
@@ -184,6 +189,142 @@ bool shared_timed_mutex::try_lock_shared_until(std::chrono::time_point<Clock, Du
     return true;
 }
 
+// Shared mutex with a third, upgradeable mode. An upgrade owner coexists with
+// readers but excludes writers and other upgrade owners, so it can later be
+// promoted to exclusive ownership without another writer getting in between.
+class upgrade_mutex {
+public:
+    upgrade_mutex() = default;
+    ~upgrade_mutex() = default;
+
+    upgrade_mutex(upgrade_mutex const&) = delete;
+    upgrade_mutex& operator=(upgrade_mutex const&) = delete;
+
+    // Exclusive ownership
+    void lock() {
+        unique_lock lock{mtx_};
+        while (state_ & (write_entered_ | upgradable_entered_))
+            gate1_.wait(lock);
+        state_ |= write_entered_;
+        while (state_ & n_readers_)
+            gate2_.wait(lock);
+    }
+
+    bool try_lock() {
+        unique_lock lock{mtx_};
+        if (state_ == 0) {
+            state_ = write_entered_;
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() {
+        scoped_lock lock{mtx_};
+        state_ = 0;
+        gate1_.notify_all();
+    }
+
+    // Shared ownership
+    void lock_shared() {
+        unique_lock lock{mtx_};
+        while ((state_ & write_entered_) || (state_ & n_readers_) == n_readers_)
+            gate1_.wait(lock);
+        ++state_;
+    }
+
+    bool try_lock_shared() {
+        unique_lock lock{mtx_};
+        if (!(state_ & write_entered_) && (state_ & n_readers_) != n_readers_) {
+            ++state_;
+            return true;
+        }
+        return false;
+    }
+
+    void unlock_shared() {
+        scoped_lock lock{mtx_};
+        unsigned const readers{(state_ & n_readers_) - 1};
+        --state_;
+        if (state_ & write_entered_) {
+            if (readers == 0)
+                gate2_.notify_one();
+        }
+        else {
+            if (readers == n_readers_ - 1)
+                gate1_.notify_one();
+        }
+    }
+
+    // Upgrade ownership, counted as one of the readers
+    void lock_upgrade() {
+        unique_lock lock{mtx_};
+        while ((state_ & (write_entered_ | upgradable_entered_)) || (state_ & n_readers_) == n_readers_)
+            gate1_.wait(lock);
+        state_ = (state_ | upgradable_entered_) + 1;
+    }
+
+    bool try_lock_upgrade() {
+        unique_lock lock{mtx_};
+        if (!(state_ & (write_entered_ | upgradable_entered_)) && (state_ & n_readers_) != n_readers_) {
+            state_ = (state_ | upgradable_entered_) + 1;
+            return true;
+        }
+        return false;
+    }
+
+    void unlock_upgrade() {
+        scoped_lock lock{mtx_};
+        state_ = (state_ & ~upgradable_entered_) - 1;
+        gate1_.notify_all();
+    }
+
+    // Conversions. None of them lets another writer or upgrade owner in.
+    void unlock_upgrade_and_lock() {
+        unique_lock lock{mtx_};
+        state_ = ((state_ & ~upgradable_entered_) - 1) | write_entered_;
+        while (state_ & n_readers_)
+            gate2_.wait(lock);
+    }
+
+    bool try_unlock_upgrade_and_lock() {
+        unique_lock lock{mtx_};
+        if (state_ == (upgradable_entered_ | 1)) {
+            state_ = write_entered_;
+            return true;
+        }
+        return false;
+    }
+
+    void unlock_and_lock_upgrade() {
+        scoped_lock lock{mtx_};
+        state_ = upgradable_entered_ | 1;
+        gate1_.notify_all();
+    }
+
+    void unlock_and_lock_shared() {
+        scoped_lock lock{mtx_};
+        state_ = 1;
+        gate1_.notify_all();
+    }
+
+    void unlock_upgrade_and_lock_shared() {
+        scoped_lock lock{mtx_};
+        state_ &= ~upgradable_entered_;
+        gate1_.notify_all();
+    }
+
+private:
+    static constexpr unsigned write_entered_ = 1U << (sizeof(unsigned)*CHAR_BIT - 1);
+    static constexpr unsigned upgradable_entered_ = write_entered_ >> 1;
+    static constexpr unsigned n_readers_ = ~(write_entered_ | upgradable_entered_);
+
+    mutex               mtx_;
+    condition_variable  gate1_;
+    condition_variable  gate2_;
+    unsigned            state_{0};
+};
+
 template<class Mutex>
 class shared_lock {
 public:
@@ -196,6 +337,7 @@ public:
     
     explicit shared_lock(mutex_type& mtx)
         : mtx_{std::addressof(mtx)}
+        , owns_{true}
     {
         mtx_->lock_shared();
     }
@@ -205,20 +347,20 @@ public:
 
     {}
 
-    shared_lock(mutex_type& mtx, try_to_lock) 
+    shared_lock(mutex_type& mtx, try_to_lock_t) 
         : mtx_{std::addressof(mtx)}
         , owns_{mtx.try_lock_shared()}
 
     {}
 
-    shared_lock(mutex_type& mtx, defer_lock_t) noexcept 
-        : mtx{std::addressof(mtx)}
+    shared_lock(mutex_type& mtx, adopt_lock_t) noexcept 
+        : mtx_{std::addressof(mtx)}
         , owns_{true}
     {}
 
     template <class Rep, class Period>
     shared_lock(mutex_type& mtx,
-                chrono::duration<_Rep, _Period> const& rel_time)
+                std::chrono::duration<Rep, Period> const& rel_time)
         : mtx_(std::addressof(mtx))
         , owns_(mtx.try_lock_shared_for(rel_time))
     {}
@@ -239,23 +381,24 @@ public:
         other.owns_ = false;
     }
 
-    shared_lock& operator=(shared_lock&& ohter) noexcept {
+    shared_lock& operator=(shared_lock&& other) noexcept {
         if (owns_)
-            mtx_.unlock_shared();
+            mtx_->unlock_shared();
         mtx_ = std::exchange(other.mtx_, nullptr);
         owns_ = std::exchange(other.owns_, false);
+        return *this;
     }
 
     void lock() {
         SYNC_ASSERT(mtx_ != nullptr, "shared_lock::lock, mutex is null");
-        SYNC_ASSERT(owns_, "shard_lock::lock, does not own mutex");
+        SYNC_ASSERT(!owns_, "shared_lock::lock, already owns mutex");
         mtx_->lock_shared();
         owns_ = true;
     }
 
     bool try_lock() {
         SYNC_ASSERT(mtx_ != nullptr, "shared_lock::try_lock, mutex is null");
-        SYNC_ASSERT(owns_, "shard_lock::try_lock, does not own mutex");
+        SYNC_ASSERT(!owns_, "shared_lock::try_lock, already owns mutex");
         owns_ = mtx_->try_lock_shared();
         return owns_;       
     }
@@ -263,7 +406,7 @@ public:
     template<class Rep, class Period>
     bool try_lock_for(std::chrono::duration<Rep, Period> const& rel_time) {
         SYNC_ASSERT(mtx_ != nullptr, "shared_lock::try_lock_for, mutex is null");
-        SYNC_ASSERT(owns_, "shard_lock::try_lock_for, does not own mutex");
+        SYNC_ASSERT(!owns_, "shared_lock::try_lock_for, already owns mutex");
         owns_ = mtx_->try_lock_shared_for(rel_time);
         return owns_;      
     }
@@ -271,13 +414,13 @@ public:
     template<class Clock, class Dur>
     bool try_lock_until(std::chrono::time_point<Clock, Dur> const& abs_time) {
         SYNC_ASSERT(mtx_ != nullptr, "shared_lock::try_lock_until, mutex is null");
-        SYNC_ASSERT(owns_, "shard_lock::try_lock_until, does not own mutex");
+        SYNC_ASSERT(!owns_, "shared_lock::try_lock_until, already owns mutex");
         owns_ = mtx_->try_lock_shared_until(abs_time);
         return owns_;             
     }
     
     void unlock() {
-        SYNC_ASSERT(!owns_, "shared_lock::unlock, does not own mutex");
+        SYNC_ASSERT(owns_, "shared_lock::unlock, does not own mutex");
         mtx_->unlock_shared();
         owns_ = false;
     }
@@ -312,4 +455,133 @@ inline void swap(shared_lock<Mutex>& a, shared_lock<Mutex>& b) noexcept {
     a.swap(b);
 }
 
+template<class Mutex>
+class upgrade_lock {
+public:
+    using mutex_type = Mutex;
+private:
+    mutex_type* mtx_{nullptr};
+    bool owns_{false};
+public:
+    upgrade_lock() noexcept {}
+
+    explicit upgrade_lock(mutex_type& mtx)
+        : mtx_{std::addressof(mtx)}
+        , owns_{true}
+    {
+        mtx_->lock_upgrade();
+    }
+
+    upgrade_lock(mutex_type& mtx, defer_lock_t) noexcept
+        : mtx_{std::addressof(mtx)}
+    {}
+
+    upgrade_lock(mutex_type& mtx, try_to_lock_t)
+        : mtx_{std::addressof(mtx)}
+        , owns_{mtx.try_lock_upgrade()}
+    {}
+
+    upgrade_lock(mutex_type& mtx, adopt_lock_t) noexcept
+        : mtx_{std::addressof(mtx)}
+        , owns_{true}
+    {}
+
+    // Downgrade: exclusive ownership becomes upgrade ownership without a gap
+    explicit upgrade_lock(unique_lock<mutex_type>&& ul)
+        : mtx_{ul.mutex()}
+        , owns_{ul.owns_lock()}
+    {
+        if (owns_)
+            mtx_->unlock_and_lock_upgrade();
+        ul.release();
+    }
+
+    ~upgrade_lock() {
+        if (owns_)
+            mtx_->unlock_upgrade();
+    }
+
+    upgrade_lock(upgrade_lock const&) = delete;
+    upgrade_lock& operator=(upgrade_lock const&) = delete;
+
+    upgrade_lock(upgrade_lock&& other) noexcept
+        : mtx_{std::exchange(other.mtx_, nullptr)}
+        , owns_{std::exchange(other.owns_, false)}
+    {}
+
+    upgrade_lock& operator=(upgrade_lock&& other) noexcept {
+        if (owns_)
+            mtx_->unlock_upgrade();
+        mtx_ = std::exchange(other.mtx_, nullptr);
+        owns_ = std::exchange(other.owns_, false);
+        return *this;
+    }
+
+    void lock() {
+        SYNC_ASSERT(mtx_ != nullptr, "upgrade_lock::lock, mutex is null");
+        SYNC_ASSERT(!owns_, "upgrade_lock::lock, already owns mutex");
+        mtx_->lock_upgrade();
+        owns_ = true;
+    }
+
+    bool try_lock() {
+        SYNC_ASSERT(mtx_ != nullptr, "upgrade_lock::try_lock, mutex is null");
+        SYNC_ASSERT(!owns_, "upgrade_lock::try_lock, already owns mutex");
+        owns_ = mtx_->try_lock_upgrade();
+        return owns_;
+    }
+
+    void unlock() {
+        SYNC_ASSERT(owns_, "upgrade_lock::unlock, does not own mutex");
+        mtx_->unlock_upgrade();
+        owns_ = false;
+    }
+
+    // Promotion: waits for the remaining readers to leave, this lock is left empty
+    [[nodiscard]]
+    unique_lock<mutex_type> upgrade() {
+        SYNC_ASSERT(owns_, "upgrade_lock::upgrade, does not own mutex");
+        mtx_->unlock_upgrade_and_lock();
+        owns_ = false;
+        return unique_lock<mutex_type>{*std::exchange(mtx_, nullptr), adopt_lock};
+    }
+
+    // Non-blocking promotion, fails unless this is the only owner
+    [[nodiscard]]
+    unique_lock<mutex_type> try_upgrade() {
+        SYNC_ASSERT(owns_, "upgrade_lock::try_upgrade, does not own mutex");
+        if (!mtx_->try_unlock_upgrade_and_lock())
+            return unique_lock<mutex_type>{};
+        owns_ = false;
+        return unique_lock<mutex_type>{*std::exchange(mtx_, nullptr), adopt_lock};
+    }
+
+    void swap(upgrade_lock& other) noexcept {
+        std::swap(mtx_, other.mtx_);
+        std::swap(owns_, other.owns_);
+    }
+
+    mutex_type* release() noexcept {
+        owns_ = false;
+        return std::exchange(mtx_, nullptr);
+    }
+
+    bool owns_lock() const noexcept {
+        return owns_;
+    }
+
+    explicit operator bool() const noexcept {
+        return owns_;
+    }
+
+    mutex_type* mutex() const noexcept {
+        return mtx_;
+    }
+};
+
+template<class Mutex>
+inline void swap(upgrade_lock<Mutex>& a, upgrade_lock<Mutex>& b) noexcept {
+    a.swap(b);
+}
+
 } // namespace sync
\ No newline at end of file
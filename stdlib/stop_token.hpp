@@ -2,6 +2,7 @@
 #pragma once
 
 #include "_thread.hpp"
+#include "internal/sync_spin.hpp"
 
 #include <atomic>
 #include <type_traits>
@@ -95,7 +96,7 @@ public:
         uint64_t past_state; // uninitialized
 
         do { // attempt to lock state_
-            for (;;) {
+            for (spin_wait spin;; spin.spin_once()) {
                 past_state = state_.load(std::memory_order_acquire);
                 if (stop_requested(past_state)) {
                     cb->execute();
@@ -105,7 +106,6 @@ public:
                     return false;
                 if (!is_locked(past_state))
                     break;
-                this_thread::yield();
             }
         } while (!state_.compare_exchange_weak(past_state, past_state | locked_bit_, std::memory_order_acquire));
 
@@ -140,9 +140,9 @@ public:
             if (cb->is_removed_ != nullptr) // synchronize with request_stop
                 *cb->is_removed_ = true;
         } else {
-            while (!cb->callback_finished_executing_.load(std::memory_order_acquire)) { // block
-                this_thread::yield();
-            }
+            spin_wait spin;
+            while (!cb->callback_finished_executing_.load(std::memory_order_acquire)) // block
+                spin.spin_once();
         }
         
         decrement_token_ref();
@@ -166,8 +166,8 @@ private:
         do {
             if (stop_requested(past_state))
                 return false;
-            while (is_locked(past_state)) {
-                this_thread::yield();
+            for (spin_wait spin; is_locked(past_state);) {
+                spin.spin_once();
                 past_state = state_.load(std::memory_order_acquire);
                 if (stop_requested(past_state)) {
                     return false;
@@ -181,8 +181,8 @@ private:
     void lock() noexcept { // test and test-and-set
         uint64_t past_state = state_.load(std::memory_order_relaxed);
         do {
-            while (is_locked(past_state)) {
-                this_thread::yield();
+            for (spin_wait spin; is_locked(past_state);) {
+                spin.spin_once();
                 past_state = state_.load(std::memory_order_relaxed);
             }
         } while (!state_.compare_exchange_weak(
@@ -304,7 +304,7 @@ public:
 
     ~stop_source() {
         if (stop_state_ != nullptr)
-            stop_state_->increment_source_ref();
+            stop_state_->decrement_source_ref();
     }
 
     stop_source(stop_source&& other) noexcept 
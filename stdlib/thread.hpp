@@ -19,16 +19,17 @@ public:
         , thread_{} 
     {}
 
-    template <class Fn, class... Args, std::enable_if_t<!std::is_same_v<std::remove_cv_t<std::remove_reference_t<Fn>>, jthread>, int> = 0>
+    template <class Fn, class... Args, std::enable_if_t<!std::is_same_v<std::remove_cv_t<std::remove_reference_t<Fn>>, jthread> &&
+                                                        !std::is_same_v<std::remove_cvref_t<Fn>, thread::attributes>, int> = 0>
     explicit jthread(Fn&& fn, Args&&... args)
         : stop_source_{}
-        , thread_{[](auto&& fn2, stop_token token, auto&&... args2) {
-                        if constexpr (std::is_invocable_v<Fn, stop_token, Args...>)
-                            std::invoke(std::forward<decltype(fn2)>(fn2), std::move(token), std::forward<decltype(args2)>(args2)...); 
-                        else
-                            std::invoke(std::forward<decltype(fn2)>(fn2), std::forward<decltype(args2)>(args2)...);
-                    },
-                    std::forward<Fn>(fn), stop_source_.get_token(), std::forward<Args>(args)...} 
+        , thread_{starter<Fn, Args...>{}, std::forward<Fn>(fn), stop_source_.get_token(), std::forward<Args>(args)...} 
+    {}
+
+    template <class Fn, class... Args>
+    jthread(thread::attributes const& attr, Fn&& fn, Args&&... args)
+        : stop_source_{}
+        , thread_{attr, starter<Fn, Args...>{}, std::forward<Fn>(fn), stop_source_.get_token(), std::forward<Args>(args)...} 
     {}
 
     ~jthread() noexcept {
@@ -86,6 +87,18 @@ public:
     }
 
 private:
+    // passes the stop token on when fn accepts one
+    template <class Fn, class... Args>
+    struct starter {
+        template <class Fn2, class... Args2>
+        void operator()(Fn2&& fn2, stop_token token, Args2&&... args2) const {
+            if constexpr (std::is_invocable_v<Fn, stop_token, Args...>)
+                std::invoke(std::forward<Fn2>(fn2), std::move(token), std::forward<Args2>(args2)...); 
+            else
+                std::invoke(std::forward<Fn2>(fn2), std::forward<Args2>(args2)...);
+        }
+    };
+
     stop_source stop_source_;
     thread thread_;
 };
@@ -0,0 +1,148 @@
+// block_pool.hpp
+#pragma once
+
+#include "mutex_extra.hpp"
+#include "../stdlib/internal/include/platform.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace sync {
+
+// Thread safe free lists of fixed size blocks. Freed blocks are kept for reuse instead of
+// being returned to the heap, so a steady state workload stops calling malloc altogether.
+// Each thread keeps a few free blocks per size class in front of the shared lists and moves
+// them to and from a shared list in batches, so a shared list's lock is taken once per batch
+// rather than once per block. Blocks are plain memory of their size class, a block a thread
+// cached from one block_pool may serve another; the thread frees what it still holds on exit.
+// Requests larger than max_block_size or aligned beyond block_align go straight to operator new.
+class block_pool {
+public:
+    static constexpr std::size_t min_block_size = 64;
+    static constexpr std::size_t max_block_size = 512;
+    static constexpr std::size_t block_align = alignof(std::max_align_t);
+
+    block_pool() = default;
+
+    block_pool(block_pool const&) = delete;
+    block_pool& operator=(block_pool const&) = delete;
+
+    ~block_pool() {
+        for (auto& list : lists_)
+            while (list.head_ != nullptr)
+                ::operator delete(std::exchange(list.head_, list.head_->next_), std::align_val_t{block_align});
+    }
+
+    [[nodiscard]]
+    void* allocate(std::size_t size, std::size_t align = block_align) {
+        if (size > max_block_size || align > block_align)
+            return ::operator new(size, std::align_val_t{std::max(align, block_align)});
+        std::size_t const i = index(size);
+        thread_cache::stack& cached = thread_cache::local().stacks_[i];
+        if (cached.head_ == nullptr)
+            refill(lists_[i], cached);
+        if (cached.head_ != nullptr)
+            return cached.pop();
+        return ::operator new(block_size(i), std::align_val_t{block_align});
+    }
+
+    // size and align as given to allocate
+    void deallocate(void* p, std::size_t size, std::size_t align = block_align) noexcept {
+        if (size > max_block_size || align > block_align) {
+            ::operator delete(p, std::align_val_t{std::max(align, block_align)});
+            return;
+        }
+        std::size_t const i = index(size);
+        thread_cache::stack& cached = thread_cache::local().stacks_[i];
+        if (cached.count_ == cache_size)
+            spill(lists_[i], cached);
+        cached.push(new(p) free_block{nullptr});
+    }
+
+private:
+    static constexpr std::size_t num_lists = 4; // 64, 128, 256, 512
+    static constexpr std::size_t cache_size = 32; // blocks per thread and size class
+    static constexpr std::size_t batch = cache_size / 2;
+
+    static constexpr std::size_t index(std::size_t size) noexcept {
+        std::size_t i = 0;
+        while (block_size(i) < size)
+            ++i;
+        return i;
+    }
+
+    static constexpr std::size_t block_size(std::size_t i) noexcept {
+        return min_block_size << i;
+    }
+
+    struct free_block {
+        free_block* next_;
+    };
+
+    struct alignas(SYNC_CACHE_LINE_SIZE) free_list {
+        spinlock_mutex  mtx_;
+        free_block*     head_{nullptr};
+    };
+
+    class thread_cache {
+    public:
+        struct stack {
+            void push(free_block* block) noexcept {
+                block->next_ = head_;
+                head_ = block;
+                ++count_;
+            }
+
+            free_block* pop() noexcept {
+                --count_;
+                return std::exchange(head_, head_->next_);
+            }
+
+            free_block* head_{nullptr};
+            std::size_t count_{0};
+        };
+
+        thread_cache() noexcept = default;
+
+        thread_cache(thread_cache const&) = delete;
+        thread_cache& operator=(thread_cache const&) = delete;
+
+        ~thread_cache() {
+            for (auto& cached : stacks_)
+                while (cached.head_ != nullptr)
+                    ::operator delete(cached.pop(), std::align_val_t{block_align});
+        }
+
+        static thread_cache& local() noexcept {
+            thread_local thread_cache cache;
+            return cache;
+        }
+
+        stack stacks_[num_lists];
+    };
+
+    static void refill(free_list& list, thread_cache::stack& cached) noexcept {
+        scoped_lock lock{list.mtx_};
+        for (std::size_t n = 0; n < batch && list.head_ != nullptr; ++n)
+            cached.push(std::exchange(list.head_, list.head_->next_));
+    }
+
+    // unlinks a batch from the cache before taking the lock, so only the splice is under it
+    static void spill(free_list& list, thread_cache::stack& cached) noexcept {
+        free_block* const first = cached.head_;
+        free_block* last = first;
+        for (std::size_t n = 1; n < batch; ++n)
+            last = last->next_;
+        cached.head_ = last->next_;
+        cached.count_ -= batch;
+        scoped_lock lock{list.mtx_};
+        last->next_ = list.head_;
+        list.head_ = first;
+    }
+
+    free_list lists_[num_lists];
+};
+
+} // namespace sync
@@ -2,8 +2,12 @@
 #pragma once
 
 #include "../stdlib/condition_variable.hpp"
+#include "../stdlib/internal/sync_futex.hpp"
 #include "../stdlib/mutex.hpp"
 
+#include <atomic>
+#include <cstdint>
+
 namespace sync {
 
 class manual_event {
@@ -83,7 +87,7 @@ public:
     template<class Duration>
     [[nodiscard]]
     bool wait_until(Duration&& d) noexcept {
-        std::unique_lock lock{mutex_};
+        unique_lock lock{mutex_};
         bool result = cv_.wait_until(lock, d, [&](){ return signaled_ != false; });
         if (result) 
             signaled_ = false;
@@ -96,4 +100,58 @@ private:
     bool               signaled_;
 };
 
+// Lets threads sleep until a condition, checked without any lock, becomes true.
+// A waiter announces itself with prepare_wait(), re-checks the condition and then
+// either cancel_wait()s or wait()s; notifiers make the condition true first and
+// only enter the kernel when someone is actually waiting.
+class event_count {
+public:
+    using key_type = std::uint32_t;
+
+    event_count() noexcept = default;
+
+    event_count(event_count const&) = delete;
+    event_count& operator=(event_count const&) = delete;
+
+    [[nodiscard]]
+    key_type prepare_wait() noexcept {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    void cancel_wait() noexcept {
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wait(key_type key) noexcept {
+        while (epoch_.load(std::memory_order_acquire) == key)
+            sync_futex_wait(epoch_, key);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_one() noexcept {
+        if (has_waiters()) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            sync_futex_wake(epoch_);
+        }
+    }
+
+    void notify_all() noexcept {
+        if (has_waiters()) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            sync_futex_wake_all(epoch_);
+        }
+    }
+
+private:
+    bool has_waiters() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return waiters_.load(std::memory_order_relaxed) != 0;
+    }
+
+    sync_futex_t                epoch_{0};
+    std::atomic<std::uint32_t>  waiters_{0};
+};
+
 } // namespace sync
\ No newline at end of file
@@ -0,0 +1,211 @@
+// future.hpp
+#pragma once
+
+#include "block_pool.hpp"
+#include "../stdlib/internal/sync_futex.hpp"
+#include "../stdlib/internal/include/assert.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace sync {
+
+// tag selecting the pooled sync::future overload of the thread pools' post_task
+struct pooled_t { explicit pooled_t() = default; };
+inline constexpr pooled_t pooled{};
+
+template<class T>
+struct _future_value {
+    std::optional<T> value_;
+};
+
+template<>
+struct _future_value<void> {};
+
+// Shared state of a promise / future pair, a single allocation recycled through the
+// owning block_pool (if any) once both sides have let go of it.
+template<class T>
+class _future_state : public _future_value<T> {
+public:
+    explicit _future_state(block_pool* pool) noexcept
+        : pool_{pool}
+    {}
+
+    static _future_state* make(block_pool* pool) {
+        if (pool == nullptr)
+            return new _future_state{nullptr};
+        return new(pool->allocate(sizeof(_future_state), alignof(_future_state))) _future_state{pool};
+    }
+
+    void acquire() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        if (block_pool* const pool = pool_) {
+            this->~_future_state();
+            pool->deallocate(this, sizeof(_future_state), alignof(_future_state));
+        }
+        else
+            delete this;
+    }
+
+    void make_ready() noexcept {
+        if (state_.exchange(ready_, std::memory_order_release) == waiting_)
+            sync_futex_wake_all(state_);
+    }
+
+    bool is_ready() const noexcept {
+        return state_.load(std::memory_order_acquire) == ready_;
+    }
+
+    void wait() noexcept {
+        for (std::uint32_t s = state_.load(std::memory_order_acquire); s != ready_; s = state_.load(std::memory_order_acquire)) {
+            if (s == pending_ && !state_.compare_exchange_weak(s, waiting_, std::memory_order_acquire))
+                continue;
+            sync_futex_wait(state_, waiting_);
+        }
+    }
+
+    std::exception_ptr  error_;
+    bool                retrieved_{false};
+
+private:
+    static constexpr std::uint32_t pending_ = 0;
+    static constexpr std::uint32_t waiting_ = 1;
+    static constexpr std::uint32_t ready_ = 2;
+
+    sync_futex_t                state_{pending_};
+    std::atomic<std::uint32_t>  refs_{1};
+    block_pool* const           pool_;
+};
+
+template<class T>
+class promise;
+
+// Lightweight counterpart of std::future, waiting is a single futex word
+template<class T>
+class future {
+public:
+    future() noexcept = default;
+
+    future(future&& other) noexcept
+        : state_{std::exchange(other.state_, nullptr)}
+    {}
+
+    future& operator=(future&& other) noexcept {
+        future tmp{std::move(other)};
+        std::swap(state_, tmp.state_);
+        return *this;
+    }
+
+    future(future const&) = delete;
+    future& operator=(future const&) = delete;
+
+    ~future() {
+        if (state_ != nullptr)
+            state_->release();
+    }
+
+    [[nodiscard]]
+    bool valid() const noexcept {
+        return state_ != nullptr;
+    }
+
+    [[nodiscard]]
+    bool is_ready() const noexcept {
+        return state_->is_ready();
+    }
+
+    void wait() const noexcept {
+        state_->wait();
+    }
+
+    T get() {
+        SYNC_ASSERT(valid(), "future::get, future has no state");
+        future self{std::move(*this)};
+        self.state_->wait();
+        if (self.state_->error_)
+            std::rethrow_exception(self.state_->error_);
+        if constexpr (!std::is_void_v<T>)
+            return std::move(*self.state_->value_);
+    }
+
+private:
+    friend class promise<T>;
+
+    explicit future(_future_state<T>* state) noexcept
+        : state_{state}
+    {}
+
+    _future_state<T>* state_{nullptr};
+};
+
+template<class T>
+class promise {
+public:
+    promise()
+        : state_{_future_state<T>::make(nullptr)}
+    {}
+
+    // the shared state is taken from and recycled to pool, which must outlive the future
+    explicit promise(block_pool& pool)
+        : state_{_future_state<T>::make(&pool)}
+    {}
+
+    promise(promise&& other) noexcept
+        : state_{std::exchange(other.state_, nullptr)}
+    {}
+
+    promise& operator=(promise&& other) noexcept {
+        promise tmp{std::move(other)};
+        std::swap(state_, tmp.state_);
+        return *this;
+    }
+
+    promise(promise const&) = delete;
+    promise& operator=(promise const&) = delete;
+
+    ~promise() {
+        if (state_ == nullptr)
+            return;
+        if (!state_->is_ready()) {
+            state_->error_ = std::make_exception_ptr(std::future_error{std::future_errc::broken_promise});
+            state_->make_ready();
+        }
+        state_->release();
+    }
+
+    [[nodiscard]]
+    future<T> get_future() {
+        SYNC_ASSERT(!state_->retrieved_, "promise::get_future, future already retrieved");
+        state_->retrieved_ = true;
+        state_->acquire();
+        return future<T>{state_};
+    }
+
+    template<class ...Args>
+    void set_value(Args&&... args) {
+        if constexpr (!std::is_void_v<T>)
+            state_->value_.emplace(std::forward<Args>(args)...);
+        state_->make_ready();
+    }
+
+    void set_exception(std::exception_ptr error) {
+        state_->error_ = std::move(error);
+        state_->make_ready();
+    }
+
+private:
+    _future_state<T>* state_;
+};
+
+} // namespace sync
@@ -0,0 +1,392 @@
+// lock_profiler.hpp
+#pragma once
+
+// Opt-in contention profiling. profiled<M> wraps any lockable M and records acquisitions,
+// contended acquisitions, log2 histograms of wait and hold times and the call sites that had
+// to wait; lock_profile() returns every live lock's numbers sorted by total wait time.
+// Profiling is chosen per lock through its type, profiled_if<M, false> is M itself and costs
+// nothing, so translation units never disagree about a lock's layout.
+//
+//   inline constexpr bool profile_locks = ...;
+//   sync::profiled_if<sync::fast_mutex, profile_locks> routes_mutex;
+//   ...
+//   for (auto const& stats : sync::lock_profile()) ...
+
+#include "mutex_extra.hpp"
+#include "../stdlib/mutex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <source_location>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sync {
+
+struct lock_call_site {
+    std::string     file;
+    std::uint32_t   line;
+    std::uint64_t   contended;
+    std::uint64_t   wait_ns;
+};
+
+struct lock_stats {
+    static constexpr std::size_t buckets = 40; // bucket k counts durations in [2^k, 2^(k+1)) ns
+
+    std::string                             site;   // where the lock was constructed
+    std::uint64_t                           acquisitions;
+    std::uint64_t                           contended;
+    std::uint64_t                           wait_ns;
+    std::uint64_t                           hold_ns; // exclusive holds only
+    std::array<std::uint64_t, buckets>      wait_histogram;
+    std::array<std::uint64_t, buckets>      hold_histogram;
+    std::vector<lock_call_site>             call_sites; // most waited on first
+};
+
+// Counters of one lock, shared by the lock and the registry. Counters are relaxed atomics;
+// call sites are only updated on contended acquisitions, which are slow anyway.
+class _lock_record {
+public:
+    explicit _lock_record(std::string site)
+        : site_{std::move(site)}
+    {}
+
+    void acquired(std::uint64_t wait_ns, bool contended, std::source_location const& where) noexcept {
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        wait_histogram_[bucket(wait_ns)].fetch_add(1, std::memory_order_relaxed);
+        if (!contended)
+            return;
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+
+        scoped_lock lock{sites_mutex_};
+        auto it = std::find_if(sites_.begin(), sites_.end(), [&](site_counts const& s) {
+            return s.line_ == where.line() && s.file_ == where.file_name();
+        });
+        if (it == sites_.end()) {
+            if (sites_.size() == max_sites_)
+                return;
+            it = sites_.insert(sites_.end(), site_counts{where.file_name(), where.line(), 0, 0});
+        }
+        ++it->contended_;
+        it->wait_ns_ += wait_ns;
+    }
+
+    void released(std::uint64_t hold_ns) noexcept {
+        hold_ns_.fetch_add(hold_ns, std::memory_order_relaxed);
+        hold_histogram_[bucket(hold_ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    lock_stats snapshot() const {
+        lock_stats stats{site_,
+                         acquisitions_.load(std::memory_order_relaxed),
+                         contended_.load(std::memory_order_relaxed),
+                         wait_ns_.load(std::memory_order_relaxed),
+                         hold_ns_.load(std::memory_order_relaxed),
+                         {}, {}, {}};
+        for (std::size_t k = 0; k < lock_stats::buckets; ++k) {
+            stats.wait_histogram[k] = wait_histogram_[k].load(std::memory_order_relaxed);
+            stats.hold_histogram[k] = hold_histogram_[k].load(std::memory_order_relaxed);
+        }
+        {
+            scoped_lock lock{sites_mutex_};
+            for (auto const& s : sites_)
+                stats.call_sites.push_back({s.file_, s.line_, s.contended_, s.wait_ns_});
+        }
+        std::sort(stats.call_sites.begin(), stats.call_sites.end(),
+                  [](lock_call_site const& a, lock_call_site const& b) { return a.wait_ns > b.wait_ns; });
+        return stats;
+    }
+
+    void reset() noexcept {
+        acquisitions_.store(0, std::memory_order_relaxed);
+        contended_.store(0, std::memory_order_relaxed);
+        wait_ns_.store(0, std::memory_order_relaxed);
+        hold_ns_.store(0, std::memory_order_relaxed);
+        for (std::size_t k = 0; k < lock_stats::buckets; ++k) {
+            wait_histogram_[k].store(0, std::memory_order_relaxed);
+            hold_histogram_[k].store(0, std::memory_order_relaxed);
+        }
+        scoped_lock lock{sites_mutex_};
+        sites_.clear();
+    }
+
+    _lock_record* prev_{nullptr};
+    _lock_record* next_{nullptr};
+
+private:
+    static std::size_t bucket(std::uint64_t ns) noexcept {
+        return std::min<std::size_t>(std::bit_width(ns), lock_stats::buckets - 1);
+    }
+
+    struct site_counts {
+        char const*     file_;
+        std::uint32_t   line_;
+        std::uint64_t   contended_;
+        std::uint64_t   wait_ns_;
+    };
+
+    static constexpr std::size_t max_sites_ = 16;
+
+    using counter = std::atomic<std::uint64_t>;
+
+    std::string const                       site_;
+    counter                                 acquisitions_{0};
+    counter                                 contended_{0};
+    counter                                 wait_ns_{0};
+    counter                                 hold_ns_{0};
+    std::array<counter, lock_stats::buckets> wait_histogram_{};
+    std::array<counter, lock_stats::buckets> hold_histogram_{};
+    spinlock_mutex mutable                  sites_mutex_;
+    std::vector<site_counts>                sites_;
+};
+
+// every live profiled lock, an intrusive list so registering never allocates
+class _lock_registry {
+public:
+    static _lock_registry& instance() {
+        static _lock_registry registry;
+        return registry;
+    }
+
+    void add(_lock_record* record) noexcept {
+        scoped_lock lock{mutex_};
+        record->next_ = head_;
+        if (head_ != nullptr)
+            head_->prev_ = record;
+        head_ = record;
+    }
+
+    void remove(_lock_record* record) noexcept {
+        scoped_lock lock{mutex_};
+        if (record->prev_ != nullptr)
+            record->prev_->next_ = record->next_;
+        else
+            head_ = record->next_;
+        if (record->next_ != nullptr)
+            record->next_->prev_ = record->prev_;
+    }
+
+    template<class F>
+    void for_each(F&& f) {
+        scoped_lock lock{mutex_};
+        for (_lock_record* r = head_; r != nullptr; r = r->next_)
+            f(*r);
+    }
+
+private:
+    spinlock_mutex  mutex_;
+    _lock_record*   head_{nullptr};
+};
+
+inline std::uint64_t _profile_now_ns() noexcept {
+    using namespace std::chrono;
+    return static_cast<std::uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+// Drop-in wrapper with the interface of M. Exclusive and shared acquisitions are counted,
+// hold times are measured for exclusive ownership (outermost level for recursive locks).
+// Call sites come from a defaulted std::source_location argument. Locks taken by a helper
+// (lock_guard, unique_lock, sync::lock, condition waits) report the helper; profiled_lock_guard
+// and profiled_shared_lock_guard below pass on their caller's location instead.
+template<class M>
+class profiled {
+public:
+    explicit profiled(std::source_location where = std::source_location::current())
+        : record_{std::string{where.file_name()} + ":" + std::to_string(where.line())}
+    {
+        _lock_registry::instance().add(&record_);
+    }
+
+    template<class ...Args>
+        requires (sizeof...(Args) > 0 && std::constructible_from<M, Args...>)
+    explicit profiled(Args&&... args)
+        : mtx_{std::forward<Args>(args)...}
+        , record_{"<unnamed>"}
+    {
+        _lock_registry::instance().add(&record_);
+    }
+
+    profiled(profiled const&) = delete;
+    profiled& operator=(profiled const&) = delete;
+
+    ~profiled() {
+        _lock_registry::instance().remove(&record_);
+    }
+
+    void lock(std::source_location where = std::source_location::current()) {
+        if (mtx_.try_lock()) {
+            record_.acquired(0, false, where);
+        }
+        else {
+            std::uint64_t const start = _profile_now_ns();
+            mtx_.lock();
+            record_.acquired(_profile_now_ns() - start, true, where);
+        }
+        held();
+    }
+
+    bool try_lock(std::source_location where = std::source_location::current()) {
+        if (!mtx_.try_lock())
+            return false;
+        record_.acquired(0, false, where);
+        held();
+        return true;
+    }
+
+    template<class Rep, class Period>
+        requires requires (M& m, std::chrono::duration<Rep, Period> const& d) { m.try_lock_for(d); }
+    bool try_lock_for(std::chrono::duration<Rep, Period> const& dur, std::source_location where = std::source_location::current()) {
+        return try_lock_timed(where, [&] { return mtx_.try_lock_for(dur); });
+    }
+
+    template<class Clock, class Duration>
+        requires requires (M& m, std::chrono::time_point<Clock, Duration> const& t) { m.try_lock_until(t); }
+    bool try_lock_until(std::chrono::time_point<Clock, Duration> const& time, std::source_location where = std::source_location::current()) {
+        return try_lock_timed(where, [&] { return mtx_.try_lock_until(time); });
+    }
+
+    void unlock() {
+        if (--depth_ == 0)
+            record_.released(_profile_now_ns() - hold_start_);
+        mtx_.unlock();
+    }
+
+    void lock_shared(std::source_location where = std::source_location::current())
+        requires requires (M& m) { m.lock_shared(); m.try_lock_shared(); }
+    {
+        if (mtx_.try_lock_shared()) {
+            record_.acquired(0, false, where);
+            return;
+        }
+        std::uint64_t const start = _profile_now_ns();
+        mtx_.lock_shared();
+        record_.acquired(_profile_now_ns() - start, true, where);
+    }
+
+    bool try_lock_shared(std::source_location where = std::source_location::current())
+        requires requires (M& m) { m.try_lock_shared(); }
+    {
+        if (!mtx_.try_lock_shared())
+            return false;
+        record_.acquired(0, false, where);
+        return true;
+    }
+
+    void unlock_shared()
+        requires requires (M& m) { m.unlock_shared(); }
+    {
+        mtx_.unlock_shared();
+    }
+
+    [[nodiscard]]
+    lock_stats stats() const {
+        return record_.snapshot();
+    }
+
+private:
+    template<class TryLock>
+    bool try_lock_timed(std::source_location const& where, TryLock try_lock) {
+        if (mtx_.try_lock()) {
+            record_.acquired(0, false, where);
+            held();
+            return true;
+        }
+        std::uint64_t const start = _profile_now_ns();
+        if (!try_lock())
+            return false;
+        record_.acquired(_profile_now_ns() - start, true, where);
+        held();
+        return true;
+    }
+
+    // only the owner touches depth_ and hold_start_
+    void held() noexcept {
+        if (depth_++ == 0)
+            hold_start_ = _profile_now_ns();
+    }
+
+    M               mtx_;
+    _lock_record    record_;
+    unsigned int    depth_{0};
+    std::uint64_t   hold_start_{0};
+};
+
+// statistics of every live profiled lock, the most waited on first
+inline std::vector<lock_stats> lock_profile() {
+    std::vector<lock_stats> result;
+    _lock_registry::instance().for_each([&](_lock_record const& r) { result.push_back(r.snapshot()); });
+    std::sort(result.begin(), result.end(), [](lock_stats const& a, lock_stats const& b) { return a.wait_ns > b.wait_ns; });
+    return result;
+}
+
+inline void reset_lock_profile() noexcept {
+    _lock_registry::instance().for_each([](_lock_record& r) { r.reset(); });
+}
+
+// profiled<M> when Enabled, M itself otherwise
+template<class M, bool Enabled>
+using profiled_if = std::conditional_t<Enabled, profiled<M>, M>;
+
+// Scoped exclusive lock that reports the line constructing it as the call site. Any lockable
+// is accepted, so it keeps working when profiled_if turns profiling off.
+template<class Mutex>
+class profiled_lock_guard {
+public:
+    using mutex_type = Mutex;
+
+    explicit profiled_lock_guard(mutex_type& m, std::source_location where = std::source_location::current())
+        : mtx_{m}
+    {
+        if constexpr (requires { m.lock(where); })
+            mtx_.lock(where);
+        else
+            mtx_.lock();
+    }
+
+    profiled_lock_guard(profiled_lock_guard const&) = delete;
+    profiled_lock_guard& operator=(profiled_lock_guard const&) = delete;
+
+    ~profiled_lock_guard() {
+        mtx_.unlock();
+    }
+
+private:
+    mutex_type& mtx_;
+};
+
+// shared counterpart of profiled_lock_guard
+template<class Mutex>
+class profiled_shared_lock_guard {
+public:
+    using mutex_type = Mutex;
+
+    explicit profiled_shared_lock_guard(mutex_type& m, std::source_location where = std::source_location::current())
+        : mtx_{m}
+    {
+        if constexpr (requires { m.lock_shared(where); })
+            mtx_.lock_shared(where);
+        else
+            mtx_.lock_shared();
+    }
+
+    profiled_shared_lock_guard(profiled_shared_lock_guard const&) = delete;
+    profiled_shared_lock_guard& operator=(profiled_shared_lock_guard const&) = delete;
+
+    ~profiled_shared_lock_guard() {
+        mtx_.unlock_shared();
+    }
+
+private:
+    mutex_type& mtx_;
+};
+
+} // namespace sync
@@ -1,120 +1,683 @@
 // mutex_extra.hpp
 #pragma once
 
-#include "event.hpp"
 #include "semaphore.hpp"
+#include "../stdlib/internal/sync_futex.hpp"
 #include "../stdlib/internal/sync_mutex.hpp"
+#include "../stdlib/internal/sync_spin.hpp"
+#include "../stdlib/mutex.hpp"
 #include "../stdlib/thread.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <memory>
+#include <utility>
 
 namespace sync {
 
+// test and test-and-set spinlock, waiters spin on a plain load and back off
 class spinlock_mutex {
 public:
     void lock() noexcept {
-        while (flag_.test_and_set(std::memory_order_acquire))
-            this_thread::yield();
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            spin_wait spin;
+            while (locked_.load(std::memory_order_relaxed))
+                spin.spin_once();
+        }
     }
 
     [[nodiscard]]
     bool try_lock() noexcept {
-        if (flag_.test_and_set(std::memory_order_acquire))
-            return false;
-        return true;
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
     }
     
     void unlock() noexcept {
-        flag_.clear(std::memory_order_release);
+        locked_.store(false, std::memory_order_release);
     }
     
 private:
-    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+    std::atomic_bool locked_{false};
+};
+
+// fair ticket lock, waiters back off in proportion to their distance from the head of the queue
+class ticket_mutex {
+public:
+    static constexpr std::uint32_t default_backoff = 32;
+
+    explicit ticket_mutex(std::uint32_t backoff = default_backoff) noexcept
+        : backoff_{backoff}
+    {}
+
+    ticket_mutex(ticket_mutex const&) = delete;
+    ticket_mutex& operator=(ticket_mutex const&) = delete;
+
+    void lock() noexcept {
+        std::uint32_t const ticket = next_ticket_.fetch_add(1, std::memory_order_relaxed);
+        for (;;) {
+            std::uint32_t const serving = now_serving_.load(std::memory_order_acquire);
+            if (serving == ticket)
+                return;
+            for (std::uint32_t i = (ticket - serving) * backoff_; i != 0; --i)
+                sync_cpu_relax();
+        }
+    }
+
+    // never takes a ticket, only succeeds if nobody holds or waits for the lock
+    [[nodiscard]]
+    bool try_lock() noexcept {
+        std::uint32_t serving = now_serving_.load(std::memory_order_acquire);
+        return next_ticket_.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        now_serving_.store(now_serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic<std::uint32_t> next_ticket_{0};
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic<std::uint32_t> now_serving_{0};
+    std::uint32_t const backoff_;
+};
+
+// queue lock nodes, padded so every waiter spins on its own cache line
+struct alignas(SYNC_CACHE_LINE_SIZE) _queue_lock_node {
+    std::atomic<_queue_lock_node*>  next_{nullptr};
+    std::atomic_bool                locked_{false};
+    _queue_lock_node*               free_next_{nullptr};
+};
+
+// Nodes are recycled through a per thread free list and handed to a process wide
+// pool on thread exit, they are never deleted.
+class _queue_lock_node_cache {
+public:
+    ~_queue_lock_node_cache() {
+        if (head_ == nullptr)
+            return;
+        _queue_lock_node* tail = head_;
+        while (tail->free_next_ != nullptr)
+            tail = tail->free_next_;
+        scoped_lock lock{global().mtx_};
+        tail->free_next_ = global().head_;
+        global().head_ = head_;
+    }
+
+    [[nodiscard]]
+    _queue_lock_node* acquire() {
+        if (head_ == nullptr) {
+            scoped_lock lock{global().mtx_};
+            if (global().head_ == nullptr)
+                return new _queue_lock_node;
+            head_ = std::exchange(global().head_, global().head_->free_next_);
+            head_->free_next_ = nullptr;
+        }
+        return std::exchange(head_, head_->free_next_);
+    }
+
+    void release(_queue_lock_node* node) noexcept {
+        node->free_next_ = head_;
+        head_ = node;
+    }
+
+    static _queue_lock_node_cache& local() {
+        thread_local _queue_lock_node_cache cache;
+        return cache;
+    }
+
+private:
+    struct pool {
+        spinlock_mutex      mtx_;
+        _queue_lock_node*   head_{nullptr};
+    };
+
+    static pool& global() {
+        static pool p;
+        return p;
+    }
+
+    _queue_lock_node* head_{nullptr};
+};
+
+// MCS queue lock, FIFO hand off, each waiter spins on its own node
+class mcs_mutex {
+public:
+    mcs_mutex() = default;
+
+    mcs_mutex(mcs_mutex const&) = delete;
+    mcs_mutex& operator=(mcs_mutex const&) = delete;
+
+    void lock() {
+        _queue_lock_node* const node = _queue_lock_node_cache::local().acquire();
+        node->next_.store(nullptr, std::memory_order_relaxed);
+        node->locked_.store(true, std::memory_order_relaxed);
+
+        if (_queue_lock_node* const pred = tail_.exchange(node, std::memory_order_acq_rel); pred != nullptr) {
+            pred->next_.store(node, std::memory_order_release);
+            spin_wait spin;
+            while (node->locked_.load(std::memory_order_acquire))
+                spin.spin_once();
+        }
+        owner_ = node;
+    }
+
+    [[nodiscard]]
+    bool try_lock() {
+        if (tail_.load(std::memory_order_relaxed) != nullptr)
+            return false;
+
+        _queue_lock_node* const node = _queue_lock_node_cache::local().acquire();
+        node->next_.store(nullptr, std::memory_order_relaxed);
+
+        _queue_lock_node* expected = nullptr;
+        if (!tail_.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+            _queue_lock_node_cache::local().release(node);
+            return false;
+        }
+        owner_ = node;
+        return true;
+    }
+
+    void unlock() noexcept {
+        _queue_lock_node* const node = owner_;
+        _queue_lock_node* next = node->next_.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            _queue_lock_node* expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                _queue_lock_node_cache::local().release(node);
+                return;
+            }
+            spin_wait spin;
+            while ((next = node->next_.load(std::memory_order_acquire)) == nullptr) // successor is linking in
+                spin.spin_once();
+        }
+        next->locked_.store(false, std::memory_order_release);
+        _queue_lock_node_cache::local().release(node);
+    }
+
+private:
+    std::atomic<_queue_lock_node*>  tail_{nullptr};
+    _queue_lock_node*               owner_{nullptr};
+};
+
+// CLH queue lock, FIFO hand off, each waiter spins on its predecessor's node
+// and adopts it on unlock. An unlock that leaves its node at the tail also tags the
+// tail word as released, so try_lock decides with a single CAS on that word and never
+// looks at a node that may have been recycled and queued again in the meantime.
+class clh_mutex {
+public:
+    clh_mutex()
+        : tail_{word(_queue_lock_node_cache::local().acquire()) | released_}
+    {
+        node_of(tail_.load(std::memory_order_relaxed))->locked_.store(false, std::memory_order_relaxed);
+    }
+
+    ~clh_mutex() {
+        _queue_lock_node_cache::local().release(node_of(tail_.load(std::memory_order_relaxed)));
+    }
+
+    clh_mutex(clh_mutex const&) = delete;
+    clh_mutex& operator=(clh_mutex const&) = delete;
+
+    void lock() {
+        _queue_lock_node* const node = _queue_lock_node_cache::local().acquire();
+        node->locked_.store(true, std::memory_order_relaxed);
+
+        std::uintptr_t const prev = tail_.exchange(word(node), std::memory_order_acq_rel);
+        _queue_lock_node* const pred = node_of(prev);
+        if (!(prev & released_)) {
+            spin_wait spin;
+            while (pred->locked_.load(std::memory_order_acquire))
+                spin.spin_once();
+        }
+        owner_ = node;
+        pred_ = pred;
+    }
+
+    // succeeds only if the tail is tagged released, which also proves its node is free
+    [[nodiscard]]
+    bool try_lock() {
+        std::uintptr_t expected = tail_.load(std::memory_order_relaxed);
+        if (!(expected & released_))
+            return false;
+
+        _queue_lock_node* const node = _queue_lock_node_cache::local().acquire();
+        node->locked_.store(true, std::memory_order_relaxed);
+        if (!tail_.compare_exchange_strong(expected, word(node), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            _queue_lock_node_cache::local().release(node);
+            return false;
+        }
+        owner_ = node;
+        pred_ = node_of(expected);
+        return true;
+    }
+
+    void unlock() noexcept {
+        _queue_lock_node* const node = owner_;
+        _queue_lock_node* const pred = pred_;
+        node->locked_.store(false, std::memory_order_release);
+        // fails if a successor has queued up, it spins on locked_ instead
+        std::uintptr_t expected = word(node);
+        (void)tail_.compare_exchange_strong(expected, word(node) | released_, std::memory_order_release, std::memory_order_relaxed);
+        _queue_lock_node_cache::local().release(pred);
+    }
+
+private:
+    static constexpr std::uintptr_t released_ = 1; // nodes are cache line aligned, the low bit is free
+
+    static std::uintptr_t word(_queue_lock_node* node) noexcept {
+        return reinterpret_cast<std::uintptr_t>(node);
+    }
+
+    static _queue_lock_node* node_of(std::uintptr_t w) noexcept {
+        return reinterpret_cast<_queue_lock_node*>(w & ~released_);
+    }
+
+    std::atomic<std::uintptr_t>     tail_;
+    _queue_lock_node*               owner_{nullptr};
+    _queue_lock_node*               pred_{nullptr};
 };
 
+// futex mutex which spins adaptively before parking,
+// the spin budget follows the recent hold times of this mutex
 class fast_mutex {
 public:
+    static constexpr unsigned int default_max_spin = 200;
+
+    fast_mutex() noexcept = default;
+
+    explicit fast_mutex(unsigned int max_spin) noexcept
+        : max_spin_{max_spin}
+    {}
+
+    fast_mutex(fast_mutex const&) = delete;
+    fast_mutex& operator=(fast_mutex const&) = delete;
+
     void lock() noexcept {
-        if (state_.exchange(1, std::memory_order_acquire))
-            while (state_.exchange(2, std::memory_order_acquire))
-                event_.wait();
+        std::uint32_t expected = 0;
+        if (!state_.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
+            lock_contended();
     }
 
     [[nodiscard]]
     bool try_lock() noexcept {
-        unsigned int expected = 0;
-        if (state_.compare_exchange_weak(expected, 1, std::memory_order_acquire))
-            return true;
-        return false;
+        std::uint32_t expected = 0;
+        return state_.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
     }
     
     void unlock() noexcept {
         if (state_.exchange(0, std::memory_order_release) == 2)
-            event_.signal();
+            sync_futex_wake(state_);
     }
     
 private:
-    std::atomic_uint    state_{0};
-    auto_event          event_;
+    void lock_contended() noexcept {
+        unsigned int const budget = spin_.load(std::memory_order_relaxed);
+        unsigned int const limit = std::min(max_spin_, budget * 2 + 10);
+        unsigned int spins = 0;
+        for (unsigned int backoff = 1; spins < limit; backoff = std::min(backoff * 2, max_backoff_)) {
+            for (unsigned int i = 0; i < backoff && spins < limit; ++i, ++spins)
+                sync_cpu_relax();
+            if (state_.load(std::memory_order_relaxed) == 0 && try_lock()) {
+                learn(budget, spins);
+                return;
+            }
+        }
+
+        learn(budget, limit);
+        while (state_.exchange(2, std::memory_order_acquire) != 0)
+            sync_futex_wait(state_, 2);
+    }
+
+    void learn(unsigned int budget, unsigned int spins) noexcept {
+        int const delta = (static_cast<int>(spins) - static_cast<int>(budget)) / 8;
+        spin_.store(static_cast<unsigned int>(static_cast<int>(budget) + delta), std::memory_order_relaxed);
+    }
+
+    static constexpr unsigned int max_backoff_ = 16;
+
+    sync_futex_t        state_{0};
+    std::atomic_uint    spin_{0};
+    unsigned int const  max_spin_{default_max_spin};
 };
 
+// Phase-fair rwlock in a single futex word. A writer first claims the writer bit, which
+// turns away readers arriving after it, then waits for the readers already inside to leave.
+// Its unlock advances the phase counter and wakes every sleeper with one FUTEX_WAKE; readers
+// that had to wait may then enter even if the next writer has already claimed the writer bit,
+// so reader and writer phases alternate and neither side starves. The counter is wide enough
+// that a waiter cannot miss a tenure unless 2048 writers finish without it looking once.
 class fast_shared_mutex {
-public:	
+public:
+    fast_shared_mutex() noexcept = default;
+
+    fast_shared_mutex(fast_shared_mutex const&) = delete;
+    fast_shared_mutex& operator=(fast_shared_mutex const&) = delete;
+
     void lock_shared() noexcept {
-        if (rdcount_.fetch_add(-1, std::memory_order_acquire) < 1)
-            rdsem_.wait();
+        std::uint32_t s = state_.load(std::memory_order_relaxed);
+        bool waited = false;
+        bool turn = false; // a writer has finished since this reader started waiting
+        std::uint32_t phase = 0;
+        for (spin_wait spin;;) {
+            turn = turn || (waited && (s & phase_mask_) != phase);
+            if (!(s & writer_active_) && (!(s & writer_waiting_) || turn)) {
+                if ((s & readers_) == readers_) {
+                    // the reader count is full, one more would carry into the writer bits
+                    spin.spin_once();
+                    s = state_.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (state_.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                    return;
+                continue;
+            }
+            if (!waited) {
+                waited = true;
+                phase = s & phase_mask_;
+            }
+            if (!spin.try_spin())
+                sleep(s);
+            s = state_.load(std::memory_order_relaxed);
+        }
     }
 
-    bool try_lock_shared() {
-        if (rdcount_.fetch_add(-1, std::memory_order_acquire) < 1)
-            return false;
-        return true;
+    [[nodiscard]]
+    bool try_lock_shared() noexcept {
+        std::uint32_t s = state_.load(std::memory_order_relaxed);
+        while (!(s & (writer_waiting_ | writer_active_)) && (s & readers_) != readers_)
+            if (state_.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        return false;
     }
-    
+
     void unlock_shared() noexcept {
-        if (rdcount_.fetch_add(1, std::memory_order_release) < 0)
-            if (rdwait_.fetch_add(-1, std::memory_order_acquire) == 1)
-                wrsem_.post();
+        std::uint32_t const prev = state_.fetch_sub(1, std::memory_order_release);
+        // the last reader lets a claiming writer in
+        if ((prev & readers_) == 1 && (prev & writer_waiting_) && (prev & sleepers_))
+            wake();
     }
-    
+
     void lock() noexcept {
-        wrmtx_.lock();
-        long const count{rdcount_.fetch_sub(std::numeric_limits<long>::max(), std::memory_order_acquire)};
-        if (count < std::numeric_limits<long>::max()) {
-            long const rdwait{rdwait_.fetch_add(std::numeric_limits<long>::max() - count, std::memory_order_acquire)};
-            if (rdwait + std::numeric_limits<long>::max() - count)
-                wrsem_.wait();
+        std::uint32_t s = state_.load(std::memory_order_relaxed);
+        for (spin_wait spin;;) {
+            if (!(s & writer_waiting_)) {
+                if (state_.compare_exchange_weak(s, s | writer_waiting_, std::memory_order_relaxed))
+                    break;
+                continue;
+            }
+            if (!spin.try_spin())
+                sleep(s);
+            s = state_.load(std::memory_order_relaxed);
+        }
+        s = state_.load(std::memory_order_relaxed);
+        for (spin_wait spin;;) {
+            if ((s & readers_) == 0) {
+                if (state_.compare_exchange_weak(s, s | writer_active_, std::memory_order_acquire, std::memory_order_relaxed))
+                    return;
+                continue;
+            }
+            if (!spin.try_spin())
+                sleep(s);
+            s = state_.load(std::memory_order_relaxed);
         }
     }
 
     [[nodiscard]]
-    bool try_lock() {
-        if (!wrmtx_.try_lock())
-            return false;
-        long const count{rdcount_.fetch_sub(std::numeric_limits<long>::max(), std::memory_order_acquire)};
-        if (count < std::numeric_limits<long>::max()) {
-            long const rdwait{rdwait_.fetch_add(std::numeric_limits<long>::max() - count, std::memory_order_acquire)};
-            if (!(rdwait + std::numeric_limits<long>::max() - count))
+    bool try_lock() noexcept {
+        std::uint32_t s = state_.load(std::memory_order_relaxed);
+        while (!(s & (readers_ | writer_waiting_)))
+            if (state_.compare_exchange_weak(s, s | writer_waiting_ | writer_active_, std::memory_order_acquire, std::memory_order_relaxed))
                 return true;
+        return false;
+    }
+
+    void unlock() noexcept {
+        std::uint32_t s = state_.load(std::memory_order_relaxed);
+        while (!state_.compare_exchange_weak(s, (s + phase_one_) & ~(writer_active_ | writer_waiting_ | sleepers_), std::memory_order_release, std::memory_order_relaxed));
+        if (s & sleepers_)
+            sync_futex_wake_all(state_);
+    }
+
+private:
+    static constexpr std::uint32_t readers_ = (1U << 18) - 1;
+    static constexpr std::uint32_t writer_active_ = 1U << 18;
+    static constexpr std::uint32_t writer_waiting_ = 1U << 19;
+    static constexpr std::uint32_t sleepers_ = 1U << 20;
+    // the top 11 bits count finished writers and wrap around
+    static constexpr std::uint32_t phase_one_ = 1U << 21;
+    static constexpr std::uint32_t phase_mask_ = ~(phase_one_ - 1);
+
+    // sleeps unless the state has moved on from s
+    void sleep(std::uint32_t s) noexcept {
+        if (!(s & sleepers_) && !state_.compare_exchange_strong(s, s | sleepers_, std::memory_order_relaxed))
+            return;
+        sync_futex_wait(state_, s | sleepers_);
+    }
+
+    void wake() noexcept {
+        state_.fetch_and(~sleepers_, std::memory_order_relaxed);
+        sync_futex_wake_all(state_);
+    }
+
+    sync_futex_t state_{0};
+};
+
+// Reader-scalable rwlock for read-mostly data. Every thread counts its shared locks in a slot
+// of its own cache line, so readers never write to a line that other readers write. A writer
+// raises a flag, which turns new readers away, and waits for every slot to drain; readers
+// that met the flag sleep until the writer is done.
+// Two deliberate departures from a BRAVO style reader-biased lock:
+//  - slots are assigned per thread (round robin over a power of two, at most one per usable
+//    cpu), not by sched_getcpu(): unlock_shared() carries no token, and a reader that
+//    migrated between lock and unlock must still find the slot it counted itself in.
+//  - there is no separate biased mode to revoke and re-enable. Readers always take the
+//    slot path and a waiting writer always wins over readers that arrive after it, so the
+//    lock is writer-preferring; with frequent writers use fast_shared_mutex instead.
+class scalable_shared_mutex {
+public:
+    scalable_shared_mutex()
+        : mask_{std::bit_ceil(std::clamp(thread::hardware_concurrency(), 1U, max_slots_)) - 1}
+        , slots_{std::make_unique<slot[]>(mask_ + 1)}
+    {}
+
+    scalable_shared_mutex(scalable_shared_mutex const&) = delete;
+    scalable_shared_mutex& operator=(scalable_shared_mutex const&) = delete;
+
+    void lock_shared() noexcept {
+        slot& s = my_slot();
+        for (;;) {
+            s.readers_.fetch_add(1, std::memory_order_seq_cst);
+            if (writer_.load(std::memory_order_seq_cst) == 0)
+                return;
+            leave(s);
+            wait_for_writer();
         }
-        rdcount_.fetch_add(std::numeric_limits<long>::max(), std::memory_order_release);
+    }
+
+    [[nodiscard]]
+    bool try_lock_shared() noexcept {
+        slot& s = my_slot();
+        s.readers_.fetch_add(1, std::memory_order_seq_cst);
+        if (writer_.load(std::memory_order_seq_cst) == 0)
+            return true;
+        leave(s);
         return false;
     }
-    
+
+    void unlock_shared() noexcept {
+        leave(my_slot());
+    }
+
+    void lock() noexcept {
+        writers_.lock();
+        writer_.store(writing_, std::memory_order_seq_cst);
+        for (std::uint32_t i = 0; i <= mask_; ++i) {
+            sync_futex_t& readers = slots_[i].readers_;
+            for (spin_wait spin; readers.load(std::memory_order_seq_cst) != 0;)
+                if (!spin.try_spin())
+                    if (std::uint32_t const n = readers.load(std::memory_order_seq_cst); n != 0)
+                        sync_futex_wait(readers, n);
+        }
+    }
+
+    [[nodiscard]]
+    bool try_lock() noexcept {
+        if (!writers_.try_lock())
+            return false;
+        writer_.store(writing_, std::memory_order_seq_cst);
+        for (std::uint32_t i = 0; i <= mask_; ++i)
+            if (slots_[i].readers_.load(std::memory_order_seq_cst) != 0) {
+                unlock();
+                return false;
+            }
+        return true;
+    }
+
     void unlock() noexcept {
-        int const count = rdcount_.fetch_add(std::numeric_limits<long>::max(), std::memory_order_release);
-        if (count < 0)
-            rdsem_.post(-count);
-        wrmtx_.unlock();
+        if (writer_.exchange(0, std::memory_order_release) == sleepers_)
+            sync_futex_wake_all(writer_);
+        writers_.unlock();
     }
-    
+
+private:
+    static constexpr unsigned int max_slots_ = 256;
+    static constexpr std::uint32_t writing_ = 1;
+    static constexpr std::uint32_t sleepers_ = 2; // writing, and readers are asleep
+
+    struct alignas(SYNC_CACHE_LINE_SIZE) slot {
+        sync_futex_t readers_{0};
+    };
+
+    slot& my_slot() noexcept {
+        static std::atomic_uint next{0};
+        static thread_local unsigned int const index = next.fetch_add(1, std::memory_order_relaxed);
+        return slots_[index & mask_];
+    }
+
+    // the last reader out of a slot wakes a writer that may be waiting for it
+    void leave(slot& s) noexcept {
+        if (s.readers_.fetch_sub(1, std::memory_order_seq_cst) == 1 && writer_.load(std::memory_order_seq_cst) != 0)
+            sync_futex_wake(s.readers_);
+    }
+
+    void wait_for_writer() noexcept {
+        for (spin_wait spin;;) {
+            std::uint32_t w = writer_.load(std::memory_order_acquire);
+            if (w == 0)
+                return;
+            if (spin.try_spin())
+                continue;
+            if (w == sleepers_ || writer_.compare_exchange_weak(w, sleepers_, std::memory_order_acquire))
+                sync_futex_wait(writer_, sleepers_);
+        }
+    }
+
+    std::uint32_t const         mask_;
+    std::unique_ptr<slot[]>     slots_;
+    alignas(SYNC_CACHE_LINE_SIZE)
+    sync_futex_t                writer_{0};
+    fast_mutex                  writers_;
+};
+
+// Rwlock with optimistic reads. A writer makes the version odd while it holds the lock and
+// even again on unlock; an optimistic reader takes the version as its stamp, reads, and then
+// validates that the version has not moved. The optimistic path only loads, so readers of a
+// hot struct never write to its cache line. An optimistic reader races the writers, so the
+// data it reads must be atomics (relaxed is enough, the stamp orders them) written through
+// atomics as well; a plain copy is a data race even if it is thrown away after a failed
+// validate. seqlock shows how to keep a whole value in relaxed words.
+// Shared and exclusive modes are those of fast_shared_mutex.
+class stamped_mutex {
+public:
+    using stamp_type = std::uint64_t;
+
+    stamped_mutex() noexcept = default;
+
+    stamped_mutex(stamped_mutex const&) = delete;
+    stamped_mutex& operator=(stamped_mutex const&) = delete;
+
+    // 0 while a writer holds the lock, validate always fails for it
+    [[nodiscard]]
+    stamp_type try_optimistic_read() const noexcept {
+        stamp_type const v = version_.load(std::memory_order_acquire);
+        return (v & 1) ? 0 : v;
+    }
+
+    [[nodiscard]]
+    bool validate(stamp_type stamp) const noexcept {
+        // orders the reads made under the stamp before the version check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return stamp != 0 && version_.load(std::memory_order_relaxed) == stamp;
+    }
+
+    void lock() noexcept {
+        lock_.lock();
+        enter();
+    }
+
+    [[nodiscard]]
+    bool try_lock() noexcept {
+        if (!lock_.try_lock())
+            return false;
+        enter();
+        return true;
+    }
+
+    void unlock() noexcept {
+        version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        lock_.unlock();
+    }
+
+    void lock_shared() noexcept {
+        lock_.lock_shared();
+    }
+
+    [[nodiscard]]
+    bool try_lock_shared() noexcept {
+        return lock_.try_lock_shared();
+    }
+
+    void unlock_shared() noexcept {
+        lock_.unlock_shared();
+    }
+
+    // Conversions from an optimistic read, they fail without blocking if the lock is
+    // taken or a writer has been in since the stamp was issued.
+    [[nodiscard]]
+    bool try_convert_to_shared(stamp_type stamp) noexcept {
+        if (stamp == 0 || !lock_.try_lock_shared())
+            return false;
+        if (version_.load(std::memory_order_relaxed) == stamp)
+            return true;
+        lock_.unlock_shared();
+        return false;
+    }
+
+    [[nodiscard]]
+    bool try_convert_to_exclusive(stamp_type stamp) noexcept {
+        if (stamp == 0 || !lock_.try_lock())
+            return false;
+        if (version_.load(std::memory_order_relaxed) == stamp) {
+            enter();
+            return true;
+        }
+        lock_.unlock();
+        return false;
+    }
+
 private:
-    semaphore       	wrsem_{0};
-    semaphore       	rdsem_{0};
-    fast_mutex          wrmtx_;
-    std::atomic_long 	rdcount_{std::numeric_limits<long>::max()};
-    std::atomic_long 	rdwait_{0};	
+    void enter() noexcept {
+        version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // keeps the writer's data stores from becoming visible before the odd version
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // even when no writer is inside, never 0 so that 0 can mean "no stamp"
+    std::atomic<stamp_type> version_{2};
+    fast_shared_mutex       lock_;
 };
 
 namespace os {
@@ -0,0 +1,156 @@
+// parallel.hpp
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Loop parallelism over the thread pools. Index ranges are split in halves recursively,
+// one half forked into a task_group and the other kept by the current thread, until a
+// piece is no larger than grain.
+// A grain of 0 partitions adaptively: the range is halved only until every worker has about
+// two pieces, and a piece that another thread stole is halved a few more times, since a
+// steal means some thread ran out of work. Even loops stay coarse, uneven ones are refined
+// where the work is.
+// If fn or op throws, the pieces already forked still finish and one of the exceptions is
+// rethrown; other elements may or may not have been visited.
+
+namespace sync {
+
+template<class Pool, std::integral I>
+I _auto_grain(Pool const& pool, I n) noexcept {
+    I const pieces = static_cast<I>(8 * (pool.size() + 1));
+    return std::max(I{1}, static_cast<I>(n / pieces));
+}
+
+// decides whether a piece is split further, see the adaptive mode above
+template<std::integral I>
+class _splitter {
+public:
+    template<class Pool>
+    _splitter(Pool const& pool, I grain) noexcept
+        : grain_{grain > 0 ? grain : I{0}}
+        , depth_{static_cast<unsigned int>(std::bit_width(pool.size() + 1)) + 1}
+    {}
+
+    bool divisible(I n) const noexcept {
+        return grain_ > 0 ? n > grain_ : depth_ > 0 && n > 1;
+    }
+
+    void split() noexcept {
+        if (grain_ == 0)
+            --depth_;
+    }
+
+    // the splitter of a forked piece, called where the piece runs
+    _splitter forked() const noexcept {
+        _splitter s = *this;
+        if (std::this_thread::get_id() != owner_) {
+            s.depth_ += steal_depth_;
+            s.owner_ = std::this_thread::get_id();
+        }
+        return s;
+    }
+
+private:
+    static constexpr unsigned int steal_depth_ = 3;
+
+    I               grain_;
+    unsigned int    depth_;
+    std::thread::id owner_{std::this_thread::get_id()};
+};
+
+template<class Pool, std::integral I, class F>
+void _parallel_for(Pool& pool, I begin, I end, _splitter<I> split, F const& fn) {
+    task_group group{pool};
+    while (split.divisible(end - begin)) {
+        I const mid = static_cast<I>(begin + (end - begin) / 2);
+        split.split();
+        group.fork([&pool, &fn, mid, end, split] { _parallel_for(pool, mid, end, split.forked(), fn); });
+        end = mid;
+    }
+    for (; begin != end; ++begin)
+        fn(begin);
+    group.join();
+}
+
+// calls fn(i) for every i in [begin, end)
+template<class Pool, std::integral I, class F>
+void parallel_for(Pool& pool, I begin, I end, std::type_identity_t<I> grain, F const& fn) {
+    if (!(begin < end))
+        return;
+    _parallel_for(pool, begin, end, _splitter<I>{pool, grain}, fn);
+}
+
+template<class Pool, std::integral I, class T, class F, class Op>
+T _parallel_reduce(Pool& pool, I begin, I end, _splitter<I> split, T const& identity, F const& fn, Op const& op) {
+    if (!split.divisible(end - begin)) {
+        T acc = identity;
+        for (; begin != end; ++begin)
+            acc = op(std::move(acc), fn(begin));
+        return acc;
+    }
+    I const mid = static_cast<I>(begin + (end - begin) / 2);
+    split.split();
+    T right = identity;
+    task_group group{pool};
+    group.fork([&] { right = _parallel_reduce(pool, mid, end, split.forked(), identity, fn, op); });
+    T left = _parallel_reduce(pool, begin, mid, split, identity, fn, op);
+    group.join();
+    return op(std::move(left), std::move(right));
+}
+
+// folds fn(i) for every i in [begin, end) with the associative op,
+// the order of the operands is kept so op need not be commutative
+template<class Pool, std::integral I, class T, class F, class Op>
+[[nodiscard]]
+T parallel_reduce(Pool& pool, I begin, I end, std::type_identity_t<I> grain, T identity, F const& fn, Op const& op) {
+    if (!(begin < end))
+        return identity;
+    return _parallel_reduce(pool, begin, end, _splitter<I>{pool, grain}, identity, fn, op);
+}
+
+// Inclusive scan of [first, last) into d_first with the associative op, in two passes
+// over blocks of grain elements: block totals first, then each block rescanned from the
+// prefix of the blocks before it. d_first may be first. The blocks need a size up front,
+// a grain of 0 makes about eight per worker.
+template<class Pool, std::random_access_iterator InIt, std::random_access_iterator OutIt, class T, class Op>
+OutIt parallel_scan(Pool& pool, InIt first, InIt last, OutIt d_first, std::ptrdiff_t grain, T identity, Op const& op) {
+    std::ptrdiff_t const n = last - first;
+    if (n <= 0)
+        return d_first;
+    if (grain <= 0)
+        grain = _auto_grain(pool, n);
+    std::ptrdiff_t const blocks = (n + grain - 1) / grain;
+
+    std::vector<T> offsets(static_cast<std::size_t>(blocks), identity);
+    auto block_end = [=](std::ptrdiff_t b) { return std::min(n, (b + 1) * grain); };
+
+    parallel_for(pool, std::ptrdiff_t{0}, blocks - 1, std::ptrdiff_t{1}, [&](std::ptrdiff_t b) {
+        T acc = identity;
+        for (std::ptrdiff_t i = b * grain; i != block_end(b); ++i)
+            acc = op(std::move(acc), first[i]);
+        offsets[static_cast<std::size_t>(b + 1)] = std::move(acc);
+    });
+    for (std::size_t b = 1; b < offsets.size(); ++b)
+        offsets[b] = op(offsets[b - 1], std::move(offsets[b]));
+
+    parallel_for(pool, std::ptrdiff_t{0}, blocks, std::ptrdiff_t{1}, [&](std::ptrdiff_t b) {
+        T acc = offsets[static_cast<std::size_t>(b)];
+        for (std::ptrdiff_t i = b * grain; i != block_end(b); ++i) {
+            acc = op(std::move(acc), first[i]);
+            d_first[i] = acc;
+        }
+    });
+    return d_first + n;
+}
+
+} // namespace sync
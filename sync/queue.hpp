@@ -1,14 +1,25 @@
 // queue.hpp
 #pragma once
 
+#include "event.hpp"
+#include "../stdlib/internal/sync_spin.hpp"
+
+#include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <queue>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace sync {
 
@@ -17,37 +28,69 @@ class simple_blocking_queue {
 public:
     template<class ...Args>
     void push(Args&&... args) {
+        bool wake;
         {
             std::scoped_lock lock{mutex_};
             queue_.emplace(std::forward<Args>(args)...);
+            wake = waiters_ != 0;
         }
-        ready_.notify_one();
+        if (wake)
+            ready_.notify_one();
+    }
+
+    // Pushes the whole range under one lock and wakes no more waiters than there are new items.
+    // first is advanced past an item only once it is queued; if a push throws, the items
+    // already queued stay there and the waiters are woken for them.
+    template<class InputIt>
+    void push_bulk(InputIt first, InputIt last) {
+        std::size_t pushed{0};
+        std::size_t waiters;
+        try {
+            std::scoped_lock lock{mutex_};
+            waiters = waiters_;
+            for (; first != last; ++first, ++pushed)
+                queue_.emplace(*first);
+        }
+        catch (...) {
+            if (pushed != 0)
+                ready_.notify_all();
+            throw;
+        }
+        if (pushed >= waiters) {
+            if (waiters != 0)
+                ready_.notify_all();
+            return;
+        }
+        while (pushed-- != 0)
+            ready_.notify_one();
     }
 
     template<class ...Args>
     [[nodiscard]] 
     bool try_push(Args&&... args) {
+        bool wake;
         {
             std::unique_lock lock{mutex_, std::try_to_lock};
             if (!lock) 
                 return false;
             queue_.emplace(std::forward<Args>(args)...);
+            wake = waiters_ != 0;
         }
-        ready_.notify_one();
+        if (wake)
+            ready_.notify_one();
         return true;
     }
 
     [[nodiscard]] 
     std::optional<T> pop() {
         std::unique_lock lock{mutex_};
+        ++waiters_;
         ready_.wait(lock, [this]{return !queue_.empty() || done_;});
+        --waiters_;
         if (queue_.empty()) 
             return {};
 
-        if constexpr (std::is_move_constructible_v<T>)
-            std::optional<T> opt{std::move(queue_.front())};
-        else
-            std::optional<T> opt{queue_.front()};
+        std::optional<T> opt{std::move(queue_.front())};
         
         queue_.pop();
         return opt;
@@ -59,10 +102,7 @@ public:
         if (!lock || queue_.empty()) 
             return {};
 
-        if constexpr (std::is_move_constructible_v<T>)
-            std::optional<T> opt{std::move(queue_.front())};
-        else
-            std::optional<T> opt{queue_.front()};
+        std::optional<T> opt{std::move(queue_.front())};
 
         queue_.pop();
         return opt;
@@ -91,8 +131,9 @@ public:
 private:
     Queue                   queue_;
     std::condition_variable ready_;
-    std::mutex              mutex_;
-    bool                    one_{false};
+    std::mutex mutable      mutex_;
+    std::size_t             waiters_{0};
+    bool                    done_{false};
 };
 
 template<class T, 
@@ -154,13 +195,14 @@ public:
             if constexpr (std::is_move_constructible_v<T>)
                 opt.emplace(std::move(data_[pop_index_]));
             else 
-                opt.emplace(data_[m_popIntex]);
+                opt.emplace(data_[pop_index_]);
 
             data_[pop_index_].~T();
             pop_index_ = ++pop_index_ % size_;
             --count_;
         }
         open_slots_.post();
+        return opt;
     }
 
     [[nodiscard]]
@@ -211,7 +253,7 @@ public:
 private:
     Semaphore           open_slots_;
     Semaphore           full_slots_{0};
-    Mutex               mutex_;
+    Mutex mutable       mutex_;
     T*                  data_;
     unsigned int const  size_;
     unsigned int        push_index_{0};
@@ -219,132 +261,508 @@ private:
     unsigned int        count_{0};
 };
 
-template<class T, 
-        class Semaphore,
-        class Allocator = std::allocator<T>>
+// Bounded multi producer multi consumer queue (Vyukov). Every slot carries a sequence
+// number telling producers and consumers whose turn it is, so push and pop are a single
+// CAS on the head or tail index. The blocking push / pop only sleep when the queue is
+// actually full / empty. try_push / try_pop stay free of fences and never wake a thread
+// blocked in pop / push, so a side that may block needs the blocking calls on the other
+// side. The capacity is rounded up to a power of two.
+template<class T, class Allocator = std::allocator<T>>
 class lock_free_queue {
+    struct slot {
+        std::atomic_size_t              seq_;
+        alignas(T) unsigned char        storage_[sizeof(T)];
+
+        T* get() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage_));
+        }
+    };
+
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+
 public:
-    explicit lock_free_queue(unsigned int size)
-        : open_slots_{size}
-        , data_{static_cast<T*>(Allocator{}.allocate(size))}
-        , size_{size}
+    explicit lock_free_queue(std::size_t size)
+        : mask_{std::bit_ceil(size) - 1}
+        , slots_{slot_allocator{}.allocate(mask_ + 1)}
     {
         assert(size != 0);
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            new(slots_ + i) slot;
+            slots_[i].seq_.store(i, std::memory_order_relaxed);
+        }
     }
 
+    lock_free_queue(lock_free_queue const&) = delete;
+    lock_free_queue& operator=(lock_free_queue const&) = delete;
+
     ~lock_free_queue() noexcept {
-        while (count_--) {
-            data_[pop_index_].~T();
-            pop_index_ = ++pop_index_ % size_;
+        std::size_t const end = push_index_.load(std::memory_order_relaxed);
+        for (std::size_t i = pop_index_.load(std::memory_order_relaxed); i != end; ++i)
+            slots_[i & mask_].get()->~T();
+        for (std::size_t i = 0; i <= mask_; ++i)
+            slots_[i].~slot();
+        slot_allocator{}.deallocate(slots_, mask_ + 1);
+    }
+
+    template<class ...Args>
+    void push(Args&&... args) {
+        // try_push only consumes args once it has claimed a slot
+        while (!try_push(std::forward<Args>(args)...)) {
+            auto const key = not_full_.prepare_wait();
+            if (!full()) {
+                not_full_.cancel_wait();
+                continue;
+            }
+            not_full_.wait(key);
         }
-		Allocator{}.deallocate(data_, size_);
+        not_empty_.notify_one();
     }
 
     template<class ...Args>
-    void push(Args&&... args) noexcept {
-        open_slots_.wait();
+    [[nodiscard]]
+    bool try_push(Args&&... args) {
+        std::size_t pos = push_index_.load(std::memory_order_relaxed);
+        slot* s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            auto const diff = static_cast<std::ptrdiff_t>(s->seq_.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (push_index_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = push_index_.load(std::memory_order_relaxed);
+        }
 
-        new(data_ + (push_index_.fetch_add(1, std::memory_order_release) % size_)) T(std::forward<Args>(args)...);
-        count_.fetch_add(1, std::memory_order_relaxed);
+        new(s->storage_) T(std::forward<Args>(args)...);
+        s->seq_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
 
-        auto expected = push_index_.load(std::memory_order_acquire);
-        while (!push_index_.compare_exchange_weak(expected, push_index_.load(std::memory_order_acquire) % size_, std::memory_order_release, std::memory_order_relaxed))
-            expected = push_index_.load(std::memory_order_acquire);
+    [[nodiscard]]
+    T pop() {
+        for (;;) {
+            if (std::optional<T> opt = try_pop()) {
+                not_full_.notify_one();
+                return std::move(*opt);
+            }
+            auto const key = not_empty_.prepare_wait();
+            if (!empty()) {
+                not_empty_.cancel_wait();
+                continue;
+            }
+            not_empty_.wait(key);
+        }
+    }
 
-        full_slots_.post();
+    [[nodiscard]]
+    std::optional<T> try_pop() {
+        std::size_t pos = pop_index_.load(std::memory_order_relaxed);
+        slot* s;
+        for (;;) {
+            s = &slots_[pos & mask_];
+            auto const diff = static_cast<std::ptrdiff_t>(s->seq_.load(std::memory_order_acquire) - (pos + 1));
+            if (diff == 0) {
+                if (pop_index_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return {};
+            else
+                pos = pop_index_.load(std::memory_order_relaxed);
+        }
+
+        std::optional<T> opt{std::move(*s->get())};
+        s->get()->~T();
+        s->seq_.store(pos + mask_ + 1, std::memory_order_release);
+        return opt;
     }
 
-    template<class ...Args>
     [[nodiscard]]
-    bool try_push(Args&&... args) noexcept {
-        if(!open_slots_.wait_for(std::chrono::seconds(0))) 
-            return false;
+    bool empty() const noexcept {
+        return size() == 0;
+    }
 
-        new(data_ + (push_index_.fetch_add(1, std::memory_order_release) % size_)) T(std::forward<Args>(args)...);
-        count_.fetch_add(1, std::memory_order_relaxed);
+    [[nodiscard]]
+    bool full() const noexcept {
+        return size() >= capacity();
+    }
 
-        auto expected = push_index_.load(std::memory_order_acquire);
-        while (!push_index_.compare_exchange_weak(expected, push_index_.load(std::memory_order_acquire) % size_, std::memory_order_release, std::memory_order_relaxed))
-            expected = push_index_.load(std::memory_order_acquire);
+    // approximate while other threads are pushing or popping
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        std::size_t const pop = pop_index_.load(std::memory_order_acquire);
+        std::size_t const push = push_index_.load(std::memory_order_acquire);
+        return push > pop ? push - pop : 0;
+    }
 
-        full_slots_.post();
+    [[nodiscard]]
+    std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+private:
+    std::size_t const                               mask_;
+    slot* const                                     slots_;
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic_size_t push_index_{0};
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic_size_t pop_index_{0};
+    alignas(SYNC_CACHE_LINE_SIZE) event_count       not_empty_;
+    event_count                                     not_full_;
+};
+
+// Bounded single producer single consumer ring. Producer and consumer state live on
+// separate cache lines and each side caches the other side's index, so the shared
+// index is only re-read when the cached one says the ring is full / empty.
+// push_n / pop_n move a whole batch and publish it with a single release store.
+// The capacity is rounded up to a power of two.
+template<class T, class Allocator = std::allocator<T>>
+class spsc_queue {
+public:
+    explicit spsc_queue(std::size_t size)
+        : mask_{std::bit_ceil(size) - 1}
+        , data_{Allocator{}.allocate(mask_ + 1)}
+    {
+        assert(size != 0);
+    }
+
+    spsc_queue(spsc_queue const&) = delete;
+    spsc_queue& operator=(spsc_queue const&) = delete;
+
+    ~spsc_queue() noexcept {
+        std::size_t const tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+            data_[i & mask_].~T();
+        Allocator{}.deallocate(data_, mask_ + 1);
+    }
+
+    // producer
+
+    template<class ...Args>
+    void push(Args&&... args) {
+        for (spin_wait spin; !try_push(std::forward<Args>(args)...);)
+            spin.spin_once();
+    }
+
+    template<class ...Args>
+    [[nodiscard]]
+    bool try_push(Args&&... args) {
+        std::size_t const tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_)
+                return false;
+        }
+        new(data_ + (tail & mask_)) T(std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
         return true;
     }
 
+    // pushes up to n elements read from first, returns how many were pushed
+    template<class InputIt>
+    std::size_t push_n(InputIt first, std::size_t n) {
+        std::size_t const tail = tail_.load(std::memory_order_relaxed);
+        if (capacity() - (tail - head_cache_) < n)
+            head_cache_ = head_.load(std::memory_order_acquire);
+        n = std::min(n, capacity() - (tail - head_cache_));
+
+        std::size_t i = 0;
+        try {
+            for (; i < n; ++i, ++first)
+                new(data_ + ((tail + i) & mask_)) T(*first);
+        } catch (...) {
+            tail_.store(tail + i, std::memory_order_release);
+            throw;
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // consumer
+
     [[nodiscard]]
-    T pop() noexcept {
-        full_slots_.wait();
+    T pop() {
+        for (spin_wait spin;; spin.spin_once())
+            if (std::optional<T> opt = try_pop())
+                return std::move(*opt);
+    }
 
-        auto popIndex = pop_index_.fetch_add(1, std::memory_order_release);
+    [[nodiscard]]
+    std::optional<T> try_pop() {
+        std::size_t const head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_)
+                return {};
+        }
+        T& item = data_[head & mask_];
+        std::optional<T> opt{std::move(item)};
+        item.~T();
+        head_.store(head + 1, std::memory_order_release);
+        return opt;
+    }
 
-        if constexpr (std::is_move_constructible_v<T>)
-            auto item = std::move(data_[popIndex % size_])
-        else
-            auto item = data_[popIndex % size_];
+    // moves up to n elements to out, returns how many were popped
+    template<class OutputIt>
+    std::size_t pop_n(OutputIt out, std::size_t n) {
+        std::size_t const head = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ - head < n)
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+        n = std::min(n, tail_cache_ - head);
+
+        for (std::size_t i = 0; i < n; ++i, ++out) {
+            T& item = data_[(head + i) & mask_];
+            *out = std::move(item);
+            item.~T();
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
 
-        data_[popIndex % size_].~T();
-        count_.fetch_sub(1, std::memory_order_relaxed);
+    // observers, approximate while the other side is running
 
-        auto expected = pop_index_.load(std::memory_order_acquire);
-        while (!pop_index_.compare_exchange_weak(expected, pop_index_.load(std::memory_order_acquire) % size_, std::memory_order_release, std::memory_order_relaxed))
-            expected = pop_index_.load(std::memory_order_acquire);
+    [[nodiscard]]
+    bool empty() const noexcept {
+        return size() == 0;
+    }
 
-        open_slots_.post();
-        return item;
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        std::size_t const head = head_.load(std::memory_order_acquire);
+        std::size_t const tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
     }
 
     [[nodiscard]]
-    std::optional<T> try_pop() noexcept {
-		if (!full_slots_.wait_for(std::chrono::seconds{0}))
-            return false;
+    std::size_t capacity() const noexcept {
+        return mask_ + 1;
+    }
 
-        std::optional<T> opt;
-        auto popIndex = pop_index_.fetch_add(1, std::memory_order_release);
+private:
+    std::size_t const                                   mask_;
+    T* const                                            data_;
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic_size_t    tail_{0};
+    std::size_t                                         head_cache_{0};
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic_size_t    head_{0};
+    std::size_t                                         tail_cache_{0};
+};
 
-        if constexpr (std::is_move_constructible_v<T>)
-            opt.emplace(std::move(data_[popIndex % size_]));
-        else
-            opt.emplace(data_[popIndex % size_]);
+// hook for intrusive_mpsc_queue, derive from it to make a type queueable,
+// copies start out unlinked
+struct mpsc_node {
+    mpsc_node() noexcept = default;
+    mpsc_node(mpsc_node const&) noexcept {}
+    mpsc_node& operator=(mpsc_node const&) noexcept { return *this; }
 
-        data_[popIndex % size_].~T();
-        count_.fetch_sub(1, std::memory_order_relaxed);
+    std::atomic<mpsc_node*> mpsc_next_{nullptr};
+};
 
-        auto expected = pop_index_.load(std::memory_order_acquire);
-        while (!pop_index_.compare_exchange_weak(expected, pop_index_.load(std::memory_order_acquire) % size_, std::memory_order_release, std::memory_order_relaxed))
-            expected = pop_index_.load(std::memory_order_acquire);
+// Unbounded intrusive multi producer single consumer queue (Vyukov, with a stub node).
+// push is wait free and nothing is allocated, the caller owns the nodes and must keep
+// them alive until popped. The consumer only parks when the queue is empty.
+template<class T>
+class intrusive_mpsc_queue {
+    static_assert(std::is_base_of_v<mpsc_node, T>, "intrusive_mpsc_queue requires T to derive from mpsc_node");
 
-        open_slots_.post();
-        return true;
+public:
+    intrusive_mpsc_queue() noexcept = default;
+
+    intrusive_mpsc_queue(intrusive_mpsc_queue const&) = delete;
+    intrusive_mpsc_queue& operator=(intrusive_mpsc_queue const&) = delete;
+
+    // producers
+
+    void push(T* item) noexcept {
+        link(item);
+        ready_.notify_one();
+    }
+
+    // consumer
+
+    [[nodiscard]]
+    T* pop() noexcept {
+        for (spin_wait spin;;) {
+            if (T* item = try_pop())
+                return item;
+            if (spin.try_spin()) // a producer may be between its exchange and its link
+                continue;
+            auto const key = ready_.prepare_wait();
+            if (T* item = try_pop()) {
+                ready_.cancel_wait();
+                return item;
+            }
+            ready_.wait(key);
+            spin.reset();
+        }
+    }
+
+    // may spuriously return nullptr while a producer is half way through a push
+    [[nodiscard]]
+    T* try_pop() noexcept {
+        mpsc_node* tail = tail_;
+        mpsc_node* next = tail->mpsc_next_.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr)
+                return nullptr;
+            tail_ = next;
+            tail = next;
+            next = next->mpsc_next_.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        if (tail != head_.load(std::memory_order_acquire))
+            return nullptr;
+        link(&stub_);
+        next = tail->mpsc_next_.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        return nullptr;
     }
 
     [[nodiscard]]
     bool empty() const noexcept {
-        return count_.load(std::memory_order_relaxed) == 0;
+        return tail_ == &stub_ && stub_.mpsc_next_.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    void link(mpsc_node* node) noexcept {
+        node->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+        mpsc_node* const prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->mpsc_next_.store(node, std::memory_order_release);
     }
 
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic<mpsc_node*>   head_{&stub_};
+    alignas(SYNC_CACHE_LINE_SIZE) mpsc_node*                tail_{&stub_};
+    mpsc_node                                               stub_;
+    event_count                                             ready_;
+};
+
+// Chase-Lev work stealing deque (Le et al. C11 formulation). The owning thread pushes
+// and pops at the bottom without any read-modify-write on the fast path, other threads
+// steal from the top with a CAS. The circular array grows on demand, retired arrays
+// are kept until destruction since thieves may still be reading them.
+// T must be trivially copyable, typically a pointer to the actual work.
+template<class T>
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable_v<T>, "work_stealing_deque requires a trivially copyable T");
+
+    struct array {
+        explicit array(std::int64_t capacity)
+            : mask_{capacity - 1}
+            , data_{std::make_unique<std::atomic<T>[]>(static_cast<std::size_t>(capacity))}
+        {}
+
+        std::int64_t capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+        T get(std::int64_t i) const noexcept {
+            return data_[i & mask_].load(std::memory_order_relaxed);
+        }
+
+        void put(std::int64_t i, T item) noexcept {
+            data_[i & mask_].store(item, std::memory_order_relaxed);
+        }
+
+        std::int64_t const                  mask_;
+        std::unique_ptr<std::atomic<T>[]>   data_;
+    };
+
+public:
+    explicit work_stealing_deque(std::size_t capacity = 256)
+        : array_{new array{static_cast<std::int64_t>(std::bit_ceil(capacity))}}
+    {
+        assert(capacity != 0);
+    }
+
+    work_stealing_deque(work_stealing_deque const&) = delete;
+    work_stealing_deque& operator=(work_stealing_deque const&) = delete;
+
+    ~work_stealing_deque() {
+        delete array_.load(std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(T item) {
+        std::int64_t const b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t const t = top_.load(std::memory_order_acquire);
+        array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1)
+            a = grow(a, t, b);
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only, LIFO
     [[nodiscard]]
-    bool full() const noexcept {
-        return count_.load(std::memory_order_relaxed) == size_;
+    std::optional<T> pop() noexcept {
+        std::int64_t const b = bottom_.load(std::memory_order_relaxed) - 1;
+        array* const a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) { // empty
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return {};
+        }
+        T const item = a->get(b);
+        if (t == b) { // last element, race against thieves
+            bool const won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            if (!won)
+                return {};
+        }
+        return item;
     }
 
+    // any thread, FIFO, may spuriously fail when racing with other thieves
     [[nodiscard]]
-    unsigned int size() const noexcept {
-        return count_.load(std::memory_order_relaxed);
+    std::optional<T> steal() noexcept {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t const b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return {};
+        T const item = array_.load(std::memory_order_acquire)->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return {};
+        return item;
     }
 
     [[nodiscard]]
-    unsigned int capacity() const noexcept {
-        return size_;
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // approximate while other threads are running
+    [[nodiscard]]
+    std::size_t size() const noexcept {
+        std::int64_t const b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t const t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
     }
 
 private:
-    Semaphore           open_slots_;
-    Semaphore           full_slots_{0};
-    T*                  data_;
-    std::atomic_uint    push_index_{0};
-    std::atomic_uint    pop_index_{0};
-    std::atomic_uint    count_{0};
-    unsigned int const  size_;
+    array* grow(array* a, std::int64_t t, std::int64_t b) {
+        auto* const bigger = new array{a->capacity() * 2};
+        for (std::int64_t i = t; i != b; ++i)
+            bigger->put(i, a->get(i));
+        retired_.emplace_back(a);
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic<std::int64_t> top_{0};
+    alignas(SYNC_CACHE_LINE_SIZE) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<array*>                                     array_;
+    std::vector<std::unique_ptr<array>>                     retired_;
 };
 
 } // namespace sync
\ No newline at end of file
@@ -0,0 +1,102 @@
+// seqlock.hpp
+#pragma once
+
+#include "../stdlib/internal/include/platform.hpp"
+#include "../stdlib/internal/sync_spin.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace sync {
+
+// Single writer, many reader snapshot of a trivially copyable value. The writer makes the
+// sequence odd, stores the value, and makes it even again; a reader copies the value out and
+// retries if the sequence was odd or changed meanwhile. The value is kept in relaxed atomic
+// words and the sequence accesses are ordered by fences, so a reader racing the writer sees
+// a torn copy at worst, which it throws away, and never a data race.
+// store() is wait-free; it and modify() must not be called from two threads at once.
+template<class T>
+class alignas(SYNC_CACHE_LINE_SIZE) seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "seqlock requires a trivially copyable type");
+
+public:
+    using value_type = T;
+
+    seqlock() noexcept requires std::is_default_constructible_v<T>
+        : seqlock(T{})
+    {}
+
+    explicit seqlock(T const& value) noexcept {
+        write(value);
+    }
+
+    seqlock(seqlock const&) = delete;
+    seqlock& operator=(seqlock const&) = delete;
+
+    void store(T const& value) noexcept {
+        modify([&](T& current) noexcept { current = value; });
+    }
+
+    // Read-modify-write by the writer. f runs on a copy while the sequence is odd, so readers
+    // spin until it returns and modify() is only as quick as f; keep it short. f must not
+    // throw, an exception would leave the sequence odd and every reader spinning for good.
+    template<class F>
+        requires std::is_nothrow_invocable_v<F&, T&>
+    void modify(F&& f) noexcept {
+        std::uint32_t const seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        // keeps the word stores below from becoming visible before the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        T value = read();
+        f(value);
+        write(value);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]]
+    T load() const noexcept {
+        for (spin_wait spin;; spin.spin_once()) {
+            std::uint32_t const seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1)
+                continue;
+            T const value = read();
+            // orders the word loads in read() before the sequence is checked again
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq)
+                return value;
+        }
+    }
+
+private:
+    using word = std::uintptr_t;
+
+    static constexpr std::size_t words = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+
+    // may be torn unless the sequence is checked around it, or called by the writer
+    T read() const noexcept {
+        std::array<word, words> copy;
+        for (std::size_t i = 0; i < words; ++i)
+            copy[i] = data_[i].load(std::memory_order_relaxed);
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), copy.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    void write(T const& value) noexcept {
+        std::array<word, words> copy{};
+        std::memcpy(copy.data(), std::addressof(value), sizeof(T));
+        for (std::size_t i = 0; i < words; ++i)
+            data_[i].store(copy[i], std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint32_t>  seq_{0};
+    std::atomic<word>           data_[words];
+};
+
+} // namespace sync
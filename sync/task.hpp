@@ -0,0 +1,115 @@
+// task.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sync {
+
+// Move only, type erased void() callable for the thread pools. Callables of up to
+// inline_size bytes that are nothrow move constructible are stored in place, so a
+// typical lambda (or a std::packaged_task) posted to a pool is never heap allocated.
+class task {
+public:
+    static constexpr std::size_t inline_size = 48;
+
+    task() noexcept = default;
+
+    template<class F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, task> && std::is_invocable_v<std::decay_t<F>&>, int> = 0>
+    task(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>) {
+            new(storage_) Fn(std::forward<F>(f));
+            vtable_ = &inline_vtable<Fn>;
+        }
+        else {
+            new(storage_) Fn*(new Fn(std::forward<F>(f)));
+            vtable_ = &heap_vtable<Fn>;
+        }
+    }
+
+    task(task&& other) noexcept
+        : vtable_{std::exchange(other.vtable_, nullptr)}
+    {
+        if (vtable_ != nullptr)
+            vtable_->move(storage_, other.storage_);
+    }
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            vtable_ = std::exchange(other.vtable_, nullptr);
+            if (vtable_ != nullptr)
+                vtable_->move(storage_, other.storage_);
+        }
+        return *this;
+    }
+
+    task(task const&) = delete;
+    task& operator=(task const&) = delete;
+
+    ~task() {
+        reset();
+    }
+
+    void operator()() {
+        vtable_->invoke(storage_);
+    }
+
+    explicit operator bool() const noexcept {
+        return vtable_ != nullptr;
+    }
+
+    void swap(task& other) noexcept {
+        task tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+private:
+    struct vtable {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src) noexcept; // move constructs dst and destroys src
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<class Fn>
+    static constexpr bool fits_inline = sizeof(Fn) <= inline_size 
+                                     && alignof(Fn) <= alignof(std::max_align_t)
+                                     && std::is_nothrow_move_constructible_v<Fn>;
+
+    template<class Fn>
+    static constexpr vtable inline_vtable{
+        [](void* p) { (*std::launder(static_cast<Fn*>(p)))(); },
+        [](void* dst, void* src) noexcept {
+            Fn* const from = std::launder(static_cast<Fn*>(src));
+            new(dst) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* p) noexcept { std::launder(static_cast<Fn*>(p))->~Fn(); }
+    };
+
+    template<class Fn>
+    static constexpr vtable heap_vtable{
+        [](void* p) { (**std::launder(static_cast<Fn**>(p)))(); },
+        [](void* dst, void* src) noexcept { new(dst) Fn*(*std::launder(static_cast<Fn**>(src))); },
+        [](void* p) noexcept { delete *std::launder(static_cast<Fn**>(p)); }
+    };
+
+    void reset() noexcept {
+        if (vtable_ != nullptr)
+            std::exchange(vtable_, nullptr)->destroy(storage_);
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[inline_size];
+    vtable const*                           vtable_{nullptr};
+};
+
+inline void swap(task& x, task& y) noexcept {
+    x.swap(y);
+}
+
+} // namespace sync
@@ -1,129 +1,778 @@
 // thread_pool.hpp
 #pragma once
 
+#include "block_pool.hpp"
+#include "future.hpp"
+#include "queue.hpp"
+#include "task.hpp"
+#include "topology.hpp"
+#include "../stdlib/stop_token.hpp"
+#include "../stdlib/thread.hpp"
+#include "../stdlib/internal/sync_futex.hpp"
+#include "../stdlib/internal/sync_spin.hpp"
+#include "../stdlib/internal/sync_thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
 #include <functional>
 #include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace sync {
 
+// drain runs every task queued before the shutdown, cancel discards those not yet started
+enum class shutdown_mode { drain, cancel };
+
+// Placement of a pool's workers. Worker i is pinned to cpus[i % cpus.size()] or left to the
+// scheduler when cpus is empty; numa_ordered_cpus() or numa_nodes()[n].cpus give useful sets.
+// threads == 0 starts one worker per listed cpu, or one per cpu usable by the process.
+// Every worker is created with attributes, a name gets the worker index appended.
+// Cpus outside the process affinity mask are skipped when the workers are pinned.
+// A pool constructor throws system_error if a worker cannot be created (attributes the
+// system refuses, no resources left), after stopping the workers it had already started.
+struct pool_options {
+    unsigned int                threads{0};
+    std::vector<unsigned int>   cpus{};
+    thread::attributes          attributes{};
+
+    static pool_options with_threads(unsigned int n) {
+        pool_options options{};
+        options.threads = n;
+        return options;
+    }
+
+    // never 0, the pools split work by it
+    unsigned int num_threads() const noexcept {
+        if (threads != 0)
+            return threads;
+        if (!cpus.empty())
+            return static_cast<unsigned int>(cpus.size());
+        return std::max(1U, thread::hardware_concurrency());
+    }
+
+    thread::attributes worker_attributes(unsigned int i) const {
+        thread::attributes attr = attributes;
+        if (!cpus.empty())
+            attr.cpus({cpus[i % cpus.size()]});
+        if (!attr.native().name.empty())
+            attr.name(attr.native().name + "-" + std::to_string(i));
+        return attr;
+    }
+};
+
+// Number of submitted but unfinished tasks of a pool, wait() sleeps until it drops to zero
+class _pending_work {
+public:
+    void add(std::uint32_t n = 1) noexcept {
+        count_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void done(std::uint32_t n = 1) noexcept {
+        if (count_.fetch_sub(n, std::memory_order_acq_rel) == (waiting_bit_ | n))
+            sync_futex_wake_all(count_);
+    }
+
+    void wait() noexcept {
+        for (std::uint32_t state = count_.load(std::memory_order_acquire);; state = count_.load(std::memory_order_acquire)) {
+            if ((state & ~waiting_bit_) == 0) {
+                if (state != 0)
+                    count_.compare_exchange_strong(state, 0, std::memory_order_relaxed);
+                return;
+            }
+            if ((state & waiting_bit_) == 0 && !count_.compare_exchange_weak(state, state | waiting_bit_, std::memory_order_relaxed))
+                continue;
+            sync_futex_wait(count_, state | waiting_bit_);
+        }
+    }
+
+private:
+    static constexpr std::uint32_t waiting_bit_ = 1U << 31;
+
+    sync_futex_t count_{0};
+};
+
+// Counts how far a queue's push_bulk advanced over the range. push_bulk steps past an element
+// only once it is queued, so when it throws the count says how many tasks did get in.
+template<class It>
+struct _counting_iterator {
+    It              it_;
+    std::size_t*    count_;
+
+    decltype(auto) operator*() const {
+        return *it_;
+    }
+
+    _counting_iterator& operator++() {
+        ++it_;
+        ++*count_;
+        return *this;
+    }
+
+    bool operator==(_counting_iterator const& other) const {
+        return it_ == other.it_;
+    }
+};
+
 template<template<class> class Queue>
 class simple_thread_pool {
 public:
-    explicit simple_thread_pool(unsigned int num_threads_) {
+    // 0 starts one worker per usable cpu, like pool_options::threads
+    explicit simple_thread_pool(unsigned int num_threads_)
+        : simple_thread_pool{pool_options::with_threads(num_threads_)}
+    {}
+
+    explicit simple_thread_pool(pool_options const& options) {
+        unsigned int const num_threads_ = options.num_threads();
         threads_.reserve(num_threads_);
 
-        for (unsigned int i = 0; i < num_threads_; ++i)
-            threads_.emplace_back([this] {
-                std::optional<Proc> proc;
-                for (;;) {
-                    proc = queue_.pop();
-                    if (!proc)
-                        break;
-                    (*proc)();
-                }
-            });
+        try {
+            for (unsigned int i = 0; i < num_threads_; ++i)
+                threads_.emplace_back(options.worker_attributes(i), [this] {
+                    std::optional<Proc> proc;
+                    for (;;) {
+                        proc = queue_.pop();
+                        if (!proc)
+                            break;
+                        run(std::move(*proc));
+                    }
+                });
+        }
+        catch (...) {
+            // a worker could not be created, the ones already running must not outlive the pool
+            queue_.done();
+            for (auto& thread : threads_)
+                thread.join();
+            throw;
+        }
     }
 
     ~simple_thread_pool() noexcept {
+        shutdown();
+    }
+
+    // Requests stop on the pool's stop token, then finishes or discards the queued tasks
+    // according to mode and joins the workers. Discarded post_task futures report
+    // broken_promise, tasks posted once shutdown has begun are never run.
+    // Only the first call has any effect.
+    void shutdown(shutdown_mode mode = shutdown_mode::drain) {
+        if (!stop_.request_stop())
+            return;
+        if (mode == shutdown_mode::cancel)
+            cancelled_.store(true, std::memory_order_relaxed);
+        queue_.done();
         for (auto& thread : threads_)
             thread.join();
+        while (std::optional<Proc> proc = queue_.try_pop())
+            pending_.done();
+    }
+
+    // blocks until every task posted so far has finished, must not be called from a task of this pool
+    void wait_idle() noexcept {
+        pending_.wait();
+    }
+
+    // signalled when shutdown begins, long running tasks should poll it
+    [[nodiscard]]
+    stop_token get_stop_token() const noexcept {
+        return stop_.get_token();
     }
 
     template<typename F, typename... Args>
     void post_work(F&& f, Args&&... args) {
+        pending_.add();
         queue_.push(
-            [f = std::forward<F>(f), tup = std::forward_as_tuple(args...)] {
-                std::apply([&](auto&&... args){f(args...);}, tup);
+            [f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                std::apply(f, std::move(tup));
             }
         );
     }
 
     template<typename F, typename... Args>
-    auto post_task(F&& f, Args&&... args) -> std::future<std::result_of_t<F(Args...)>> {
-        using return_t = std::result_of_t<F(Args...)>;
-        auto task = std::make_unique<std::packaged_task<return_t()>>(
-            [f = std::forward<F>(f), tup = std::forward_as_tuple(args...)] {
-                std::apply([&](auto&&... args){f(args...);}, tup);
+    auto post_task(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using return_t = std::invoke_result_t<F, Args...>;
+        std::packaged_task<return_t()> work{
+            [f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(f, std::move(tup));
             }
-        );
-        auto result = task->get_future();
-        queue_.push([task = std::move(task)] { (*task)(); });
+        };
+        auto result = work.get_future();
+        pending_.add();
+        queue_.push(std::move(work));
+        return result;
+    }
+
+    // same as post_task but the result comes back through a sync::future whose shared state
+    // is recycled by the pool, so no allocation happens once the pool has warmed up.
+    // The returned future must not outlive the pool.
+    template<typename F, typename... Args>
+    auto post_task(pooled_t, F&& f, Args&&... args) -> future<std::invoke_result_t<F, Args...>> {
+        using return_t = std::invoke_result_t<F, Args...>;
+        promise<return_t> p{blocks_};
+        auto result = p.get_future();
+        pending_.add();
+        queue_.push([p = std::move(p), f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void_v<return_t>) {
+                    std::apply(f, std::move(tup));
+                    p.set_value();
+                }
+                else
+                    p.set_value(std::apply(f, std::move(tup)));
+            }
+            catch (...) {
+                p.set_exception(std::current_exception());
+            }
+        });
         return result;
     }
 
+    // posts every callable of the range with a single queue operation
+    template<std::forward_iterator ForwardIt>
+    void post_bulk(ForwardIt first, ForwardIt last) {
+        std::size_t const n = static_cast<std::size_t>(std::ranges::distance(first, last));
+        pending_.add(static_cast<std::uint32_t>(n));
+        std::size_t queued{0};
+        try {
+            queue_.push_bulk(_counting_iterator<ForwardIt>{first, &queued}, _counting_iterator<ForwardIt>{last, &queued});
+        }
+        catch (...) {
+            // the tasks left out will never report done
+            if (queued != n)
+                pending_.done(static_cast<std::uint32_t>(n - queued));
+            throw;
+        }
+    }
+
+    // posts n tasks, the k-th one calls fn(k)
+    template<typename F>
+    void post_n(std::size_t n, F const& fn) {
+        auto tasks = std::views::iota(std::size_t{0}, n)
+            | std::views::transform([&fn](std::size_t k) { return [fn, k]() mutable { fn(k); }; });
+        post_bulk(tasks.begin(), tasks.end());
+    }
+
+    // number of worker threads
+    [[nodiscard]]
+    unsigned int size() const noexcept {
+        return static_cast<unsigned int>(threads_.size());
+    }
+
+    // runs one queued task on the calling thread, returns false if there was none
+    bool run_pending_task() {
+        if (std::optional<Proc> proc = queue_.try_pop()) {
+            run(std::move(*proc));
+            return true;
+        }
+        return false;
+    }
+
+    // exact check under the queue lock, unlike a failed run_pending_task
+    [[nodiscard]]
+    bool has_pending_task() const noexcept {
+        return !queue_.empty();
+    }
+
 private:
-    using Proc = std::function<void()>;
+    using Proc = task;
+
+    void run(Proc proc) {
+        if (!cancelled_.load(std::memory_order_relaxed))
+            proc();
+        proc = Proc{};
+        pending_.done();
+    }
     
+    block_pool                  blocks_;
     Queue<Proc>                 queue_;
-    std::vector<std::thread>    threads_;
+    std::vector<thread>         threads_;
+    _pending_work               pending_;
+    stop_source                 stop_;
+    std::atomic_bool            cancelled_{false};
 };
 
 namespace { constexpr unsigned int LOOP_K = 2; }
 
+// Every worker owns a Chase-Lev deque for work spawned on that worker (LIFO for the owner,
+// stolen FIFO by the others) and a Queue inbox for work posted from outside the pool.
+// A worker out of work spins briefly, then parks on a shared event_count; submitters only
+// make a system call when some worker is actually parked.
+// With pinned workers (see pool_options) thieves try victims on their own NUMA node first,
+// and each worker allocates its own state on its own thread so it lands in node local memory.
 template<template<class> class Queue>
 class work_stealing_thread_pool {
+    using Proc = task;
+
+    struct worker {
+        worker(work_stealing_thread_pool* pool, unsigned int index)
+            : pool_{pool}
+            , index_{index}
+        {}
+
+        work_stealing_thread_pool*  pool_;
+        unsigned int                index_;
+        std::vector<unsigned int>   victims_; // the other workers, same node first
+        Queue<Proc>                 inbox_;
+        work_stealing_deque<Proc*>  local_;
+    };
+
 public:
+    // 0 starts one worker per usable cpu, like pool_options::threads
     explicit work_stealing_thread_pool(unsigned int num_threads)
-        : queues_{num_threads}
-        , count_{num_threads}
+        : work_stealing_thread_pool{pool_options::with_threads(num_threads)}
+    {}
+
+    explicit work_stealing_thread_pool(pool_options const& options)
+        : workers_(options.num_threads(), nullptr)
+        , count_{options.num_threads()}
     {
-        auto work = [this](unsigned int i) {
-            for (;;) {
-                std::optional<Proc> proc;
-                for (unsigned int n = 0; n < count_; ++n)
-                    if((proc = queues_[(i + n) % count_].try_pop())) 
-                        break;
-                if (!proc && !(proc = queues_[i].pop())) 
-                    break;
-                (*proc)();
-            }
+        std::vector<unsigned int> node_of(count_, 0);
+        if (!options.cpus.empty()) {
+            std::vector<numa_node> const nodes = numa_nodes();
+            for (unsigned int i = 0; i < count_; ++i)
+                node_of[i] = numa_node_of(nodes, options.cpus[i % options.cpus.size()]);
+        }
+
+        starting_.add(count_);
+        auto work = [this, node_of = std::move(node_of)](unsigned int i) {
+            auto* const self = new worker{this, i};
+            for (unsigned int n = 1; n < count_; ++n)
+                if (node_of[(i + n) % count_] == node_of[i])
+                    self->victims_.push_back((i + n) % count_);
+            for (unsigned int n = 1; n < count_; ++n)
+                if (node_of[(i + n) % count_] != node_of[i])
+                    self->victims_.push_back((i + n) % count_);
+            workers_[i] = self;
+            current_ = self;
+            // nobody may look at the others before all of them exist
+            starting_.done();
+            starting_.wait();
+            // closing already means another worker failed to start
+            if (!closing_.load(std::memory_order_acquire))
+                worker_loop(i);
+            current_ = nullptr;
         };
-        for (unsigned int i{0}; i < num_threads; ++i)
-            threads_.emplace_back(work, i);
+        try {
+            for (unsigned int i{0}; i < count_; ++i)
+                threads_.emplace_back(options.worker_attributes(i), work, i);
+        }
+        catch (...) {
+            // let the started workers through the start barrier straight to their exit
+            closing_.store(true, std::memory_order_release);
+            for (std::size_t i = threads_.size(); i < count_; ++i)
+                starting_.done();
+            for (auto& thread : threads_)
+                thread.join();
+            for (worker* w : workers_)
+                delete w;
+            throw;
+        }
+        starting_.wait();
     }
 
     ~work_stealing_thread_pool() noexcept
     {
+        shutdown();
+        for (worker* w : workers_)
+            delete w;
+    }
+
+    // Requests stop on the pool's stop token, then finishes or discards the pending tasks
+    // according to mode and joins the workers. Draining waits until the pool is idle, so
+    // work forked by running tasks is completed as well. Discarded post_task futures report
+    // broken_promise, tasks posted once the workers are exiting are never run.
+    // Only the first call has any effect.
+    void shutdown(shutdown_mode mode = shutdown_mode::drain) {
+        if (!stop_.request_stop())
+            return;
+        if (mode == shutdown_mode::drain)
+            wait_idle();
+        else
+            cancelled_.store(true, std::memory_order_relaxed);
+        closing_.store(true, std::memory_order_release);
+        idle_.notify_all();
         for (auto& thread : threads_)
             thread.join();
+        for (worker* w : workers_) {
+            while (std::optional<Proc*> proc = w->local_.pop()) {
+                free_node(*proc);
+                pending_.done();
+            }
+            while (std::optional<Proc> proc = w->inbox_.try_pop())
+                pending_.done();
+        }
+    }
+
+    // blocks until every task posted so far has finished, must not be called from a task of this pool
+    void wait_idle() noexcept {
+        pending_.wait();
+    }
+
+    // signalled when shutdown begins, long running tasks should poll it
+    [[nodiscard]]
+    stop_token get_stop_token() const noexcept {
+        return stop_.get_token();
     }
 
     template<typename F, typename... Args>
     void post_work(F&& f, Args&&... args) {
-        auto work = [f = std::forward<F>(f), tup = std::forward_as_tuple(args...)] {
-            std::apply([&](auto&&... args){f(args...);}, tup);
+        submit([f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(f, std::move(tup));
+        });
+    }
+
+    template<typename F, typename... Args>
+    auto post_task(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using return_t = std::invoke_result_t<F, Args...>;
+        std::packaged_task<return_t()> work{
+            [f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(f, std::move(tup));
+            }
         };
+        auto result = work.get_future();
+        submit(std::move(work));
+        return result;
+    }
+
+    // same as post_task but the result comes back through a sync::future whose shared state
+    // is recycled by the pool, so no allocation happens once the pool has warmed up.
+    // The returned future must not outlive the pool.
+    template<typename F, typename... Args>
+    auto post_task(pooled_t, F&& f, Args&&... args) -> future<std::invoke_result_t<F, Args...>> {
+        using return_t = std::invoke_result_t<F, Args...>;
+        promise<return_t> p{blocks_};
+        auto result = p.get_future();
+        submit([p = std::move(p), f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void_v<return_t>) {
+                    std::apply(f, std::move(tup));
+                    p.set_value();
+                }
+                else
+                    p.set_value(std::apply(f, std::move(tup)));
+            }
+            catch (...) {
+                p.set_exception(std::current_exception());
+            }
+        });
+        return result;
+    }
+
+    // Splits the range evenly over the worker inboxes, one queue operation each. Called from
+    // a worker, that worker's share goes to its own deque instead.
+    template<std::forward_iterator ForwardIt>
+    void post_bulk(ForwardIt first, ForwardIt last) {
+        std::size_t const n = static_cast<std::size_t>(std::ranges::distance(first, last));
+        if (n == 0)
+            return;
+        pending_.add(static_cast<std::uint32_t>(n));
+        worker* const self = this_worker();
+        unsigned int const start = index_.fetch_add(1, std::memory_order_relaxed);
+        std::size_t queued{0};
+        try {
+            for (unsigned int w = 0; w < count_ && first != last; ++w) {
+                std::size_t const share = n / count_ + (w < n % count_ ? 1 : 0);
+                ForwardIt const next = std::ranges::next(first, static_cast<std::iter_difference_t<ForwardIt>>(share));
+                worker& target = *workers_[(start + w) % count_];
+                if (&target == self)
+                    for (; first != next; ++first, ++queued)
+                        push_local(*self, Proc{*first});
+                else
+                    target.inbox_.push_bulk(_counting_iterator<ForwardIt>{first, &queued}, _counting_iterator<ForwardIt>{next, &queued});
+                first = next;
+            }
+        }
+        catch (...) {
+            // the tasks left out will never report done, the ones queued still need a worker
+            if (queued != n)
+                pending_.done(static_cast<std::uint32_t>(n - queued));
+            if (queued != 0)
+                idle_.notify_all();
+            throw;
+        }
+        if (n >= count_)
+            idle_.notify_all();
+        else
+            for (std::size_t k = 0; k < n; ++k)
+                idle_.notify_one();
+    }
+
+    // posts n tasks, the k-th one calls fn(k)
+    template<typename F>
+    void post_n(std::size_t n, F const& fn) {
+        auto tasks = std::views::iota(std::size_t{0}, n)
+            | std::views::transform([&fn](std::size_t k) { return [fn, k]() mutable { fn(k); }; });
+        post_bulk(tasks.begin(), tasks.end());
+    }
+
+    // number of worker threads
+    [[nodiscard]]
+    unsigned int size() const noexcept {
+        return count_;
+    }
+
+    // runs one queued task on the calling thread, returns false if there was none,
+    // a worker prefers its own work, any other thread steals
+    bool run_pending_task() {
+        if (worker* const self = this_worker())
+            return run_pending_task(self->index_);
+        for (unsigned int n = 0; n < count_; ++n)
+            if (steal_task(*workers_[n]))
+                return true;
+        return false;
+    }
+
+    // true while any deque or inbox holds a task, even if a steal just lost a race for it
+    [[nodiscard]]
+    bool has_pending_task() const noexcept {
+        for (worker const* w : workers_)
+            if (!w->local_.empty() || !w->inbox_.empty())
+                return true;
+        return false;
+    }
+
+private:
+    void worker_loop(unsigned int i) {
+        for (spin_wait spin;;) {
+            if (run_pending_task(i)) {
+                spin.reset();
+                continue;
+            }
+            if (spin.try_spin())
+                continue;
+            // announce the sleep before the last look, a submitter either sees us or we see its task
+            event_count::key_type const key = idle_.prepare_wait();
+            if (has_pending_task()) {
+                idle_.cancel_wait();
+                continue;
+            }
+            if (closing_.load(std::memory_order_acquire)) {
+                idle_.cancel_wait();
+                break;
+            }
+            idle_.wait(key);
+            spin.reset();
+        }
+    }
+
+    worker* this_worker() const noexcept {
+        worker* const self = current_;
+        if (self != nullptr && self->pool_ == this)
+            return self;
+        return nullptr;
+    }
+
+    // on a worker of this pool the work goes to its own deque, otherwise to an inbox
+    void submit(Proc&& work) {
+        pending_.add();
+        try {
+            if (worker* const self = this_worker())
+                push_local(*self, std::move(work));
+            else
+                push_inbox(std::move(work));
+        }
+        catch (...) {
+            pending_.done();
+            throw;
+        }
+        idle_.notify_one();
+    }
+
+    // boxes the task in a block of blocks_ for the worker's own deque
+    void push_local(worker& self, Proc&& work) {
+        Proc* const node = new(blocks_.allocate(sizeof(Proc))) Proc{std::move(work)};
+        try {
+            self.local_.push(node);
+        }
+        catch (...) {
+            free_node(node);
+            throw;
+        }
+    }
+
+    void push_inbox(Proc&& work) {
         unsigned int const i = index_.fetch_add(1, std::memory_order_relaxed);
         for (unsigned int n = 0; n < count_ * LOOP_K; ++n)
-            if (queues_[(i + n) % count_].try_push(std::move(work))) 
+            if (workers_[(i + n) % count_]->inbox_.try_push(std::move(work))) 
                 return;
-        queues_[i % count_].push(std::move(work));
+        workers_[i % count_]->inbox_.push(std::move(work));
     }
 
-    template<typename F, typename... Args>
-    auto post_task(F&& f, Args&&... args) -> std::future<std::result_of_t<F(Args...)>> {
-        using return_t = std::result_of_t<F(Args...)>;
-        auto task = std::make_unique<std::packaged_task<return_t()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-        auto result = task->get_future();
+    // own deque first, then own inbox, then steal from the others
+    bool run_pending_task(unsigned int i) {
+        worker& self = *workers_[i];
+        if (std::optional<Proc*> proc = self.local_.pop()) {
+            run_node(*proc);
+            return true;
+        }
+        if (std::optional<Proc> proc = self.inbox_.try_pop()) {
+            run(std::move(*proc));
+            return true;
+        }
+        for (unsigned int victim : self.victims_)
+            if (steal_task(*workers_[victim]))
+                return true;
+        return false;
+    }
 
-        auto work = [task = std::move(task)] { (*task)(); };
-        unsigned int const i = index_.fetch_add(1, std::memory_order_relaxed);
-        for(unsigned int n = 0; n < count_ * LOOP_K; ++n)
-            if(queues_[(i + n) % count_].try_push(std::move(work))) 
-                return result;
-        queues_[i % count_].push(std::move(work));
-        return result;
+    bool steal_task(worker& victim) {
+        if (std::optional<Proc*> proc = victim.local_.steal()) {
+            run_node(*proc);
+            return true;
+        }
+        if (std::optional<Proc> proc = victim.inbox_.try_pop()) {
+            run(std::move(*proc));
+            return true;
+        }
+        return false;
     }
 
-private:
-    using Proc = std::function<void()>;
+    void run(Proc proc) {
+        if (!cancelled_.load(std::memory_order_relaxed))
+            proc();
+        proc = Proc{};
+        pending_.done();
+    }
+
+    // deque entries are boxed tasks taken from blocks_ rather than the heap
+    void run_node(Proc* proc) {
+        struct guard {
+            work_stealing_thread_pool* pool_;
+            Proc* proc_;
+            ~guard() {
+                pool_->free_node(proc_);
+                pool_->pending_.done();
+            }
+        } g{this, proc};
+        if (!cancelled_.load(std::memory_order_relaxed))
+            (*proc)();
+    }
+
+    void free_node(Proc* proc) noexcept {
+        proc->~Proc();
+        blocks_.deallocate(proc, sizeof(Proc));
+    }
+
+    static inline thread_local worker* current_ = nullptr;
 
-    std::vector<Queue<Proc>>    queues_;
-    std::vector<std::thread>    threads_;
+    block_pool                  blocks_;
+    std::vector<worker*>        workers_;
+    _pending_work               starting_;
+    std::vector<thread>         threads_;
     std::atomic_uint            index_{0};
     unsigned int const          count_;
+    _pending_work               pending_;
+    stop_source                 stop_;
+    std::atomic_bool            cancelled_{false};
+    event_count                 idle_;
+    std::atomic_bool            closing_{false};
+};
+
+// Fork-join scope over a pool. fork() posts a child task, join() waits for all of them
+// but keeps the calling thread busy with other pending work of the pool meanwhile, so
+// recursive divide and conquer does not deadlock once every worker is joining.
+// Children forked on a work_stealing_thread_pool worker land on that worker's own deque.
+// The first exception thrown by a child is rethrown by join(), the destructor only waits.
+template<class Pool>
+class task_group {
+public:
+    explicit task_group(Pool& pool) noexcept
+        : pool_{pool}
+    {}
+
+    task_group(task_group const&) = delete;
+    task_group& operator=(task_group const&) = delete;
+
+    ~task_group() {
+        wait();
+    }
+
+    template<typename F, typename... Args>
+    void fork(F&& f, Args&&... args) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.post_work([this, f = std::forward<F>(f), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            try {
+                std::apply(f, std::move(tup));
+            }
+            catch (...) {
+                if (!failed_.test_and_set(std::memory_order_relaxed))
+                    error_ = std::current_exception();
+            }
+            finish();
+        });
+    }
+
+    void join() {
+        wait();
+        if (error_) {
+            failed_.clear(std::memory_order_relaxed);
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    void wait() {
+        for (spin_wait spin;;) {
+            std::uint32_t const state = pending_.load(std::memory_order_acquire);
+            if (state == 0)
+                return;
+            if (state == waiting_bit_) {
+                // the last child is still inside finish(), the group must outlive its wake
+                spin.spin_once();
+                continue;
+            }
+            if (pool_.run_pending_task()) {
+                spin.reset();
+                continue;
+            }
+            if (spin.try_spin())
+                continue;
+            // a failed run_pending_task may have only lost a race, keep helping while anything is queued
+            if (pool_.has_pending_task()) {
+                spin.reset();
+                continue;
+            }
+            // all remaining children are running elsewhere, sleep until the last one finishes
+            std::uint32_t expected = state;
+            if (pending_.compare_exchange_weak(expected, state | waiting_bit_, std::memory_order_relaxed))
+                sync_futex_wait(pending_, state | waiting_bit_);
+        }
+    }
+
+    // The group may be destroyed as soon as the count reads 0. With a joiner asleep, the last
+    // child first leaves just the waiting bit, which wait() does not return on, and clears it
+    // only once the wake is done.
+    void finish() noexcept {
+        std::uint32_t state = pending_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (state == (waiting_bit_ | 1)) {
+                if (pending_.compare_exchange_weak(state, waiting_bit_, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    sync_futex_wake_all(pending_);
+                    pending_.store(0, std::memory_order_release);
+                    return;
+                }
+            }
+            else if (pending_.compare_exchange_weak(state, state - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    static constexpr std::uint32_t waiting_bit_ = 1U << 31;
+
+    Pool&               pool_;
+    sync_futex_t        pending_{0};
+    std::atomic_flag    failed_;
+    std::exception_ptr  error_;
 };
 
 } // namespace sync
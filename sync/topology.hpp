@@ -0,0 +1,163 @@
+// topology.hpp
+#pragma once
+
+#include "../stdlib/thread.hpp"
+#include "../stdlib/internal/include/platform.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace sync {
+
+// a NUMA node and the cpus that belong to it
+struct numa_node {
+    unsigned int                id;
+    std::vector<unsigned int>   cpus;
+};
+
+// parses the kernel's list format, e.g. "0-3,8,10-11"
+inline std::vector<unsigned int> _parse_cpu_list(std::string_view list) {
+    std::vector<unsigned int> cpus;
+    while (!list.empty()) {
+        std::string_view const item = list.substr(0, list.find(','));
+        list.remove_prefix(std::min(list.size(), item.size() + 1));
+
+        unsigned int first = 0;
+        auto [end, ec] = std::from_chars(item.data(), item.data() + item.size(), first);
+        if (ec != std::errc{})
+            continue;
+        unsigned int last = first;
+        if (end != item.data() + item.size() && *end == '-')
+            std::from_chars(end + 1, item.data() + item.size(), last);
+        for (unsigned int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// first line of a sysfs file, empty if it cannot be read
+inline std::string _read_sysfs(std::string const& path) {
+    std::ifstream file{path};
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// The NUMA nodes of the machine as listed in /sys/devices/system/node. Where that is not
+// available (other systems, kernels without NUMA) there is a single node 0 with every cpu.
+inline std::vector<numa_node> numa_nodes() {
+    std::vector<numa_node> nodes;
+#if SYNC_LINUX
+    for (unsigned int id : _parse_cpu_list(_read_sysfs("/sys/devices/system/node/online"))) {
+        std::string const path = "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+        std::vector<unsigned int> cpus = _parse_cpu_list(_read_sysfs(path));
+        if (!cpus.empty())
+            nodes.push_back({id, std::move(cpus)});
+    }
+#endif
+    if (nodes.empty()) {
+        numa_node all{0, {}};
+        for (unsigned int cpu = 0, n = std::max(1U, std::thread::hardware_concurrency()); cpu < n; ++cpu)
+            all.cpus.push_back(cpu);
+        nodes.push_back(std::move(all));
+    }
+    return nodes;
+}
+
+// id of the node holding cpu, 0 if it is unknown
+inline unsigned int numa_node_of(std::vector<numa_node> const& nodes, unsigned int cpu) noexcept {
+    for (auto const& node : nodes)
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end())
+            return node.id;
+    return 0;
+}
+
+// every cpu the process may run on, ordered node by node, so consecutive pinned workers
+// share a node
+inline std::vector<unsigned int> numa_ordered_cpus() {
+    std::vector<unsigned int> const usable = sync_thread_usable_cpus();
+    std::vector<unsigned int> cpus;
+    for (auto const& node : numa_nodes())
+        for (unsigned int cpu : node.cpus)
+            if (usable.empty() || std::binary_search(usable.begin(), usable.end(), cpu))
+                cpus.push_back(cpu);
+    return cpus;
+}
+
+// sizes in bytes as seen from cpu 0, 0 where unknown
+struct cpu_caches {
+    std::size_t l1d{0};
+    std::size_t l2{0};
+    std::size_t l3{0};
+    std::size_t line_size{SYNC_CACHE_LINE_SIZE};
+};
+
+struct cpu_topology {
+    unsigned int            usable_cpus;    // what this process may run on, see thread::hardware_concurrency
+    unsigned int            logical_cpus;   // online hardware threads
+    unsigned int            physical_cores;
+    unsigned int            smt_width;      // hardware threads per core
+    cpu_caches              caches;
+    std::vector<numa_node>  nodes;
+};
+
+// parses sysfs cache sizes such as "48K"
+inline std::size_t _parse_size(std::string_view text) noexcept {
+    std::size_t size = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), size);
+    if (ec != std::errc{})
+        return 0;
+    if (end != text.data() + text.size()) {
+        if (*end == 'K')
+            size <<= 10;
+        else if (*end == 'M')
+            size <<= 20;
+    }
+    return size;
+}
+
+// cores, SMT and caches from /sys/devices/system/cpu, every cpu counted as a core elsewhere
+inline cpu_topology topology() {
+    cpu_topology topo{thread::hardware_concurrency(), 0, 0, 1, {}, numa_nodes()};
+#if SYNC_LINUX
+    std::string const root = "/sys/devices/system/cpu/";
+    std::vector<unsigned int> const online = _parse_cpu_list(_read_sysfs(root + "online"));
+    std::set<std::string> cores;
+    for (unsigned int cpu : online)
+        cores.insert(_read_sysfs(root + "cpu" + std::to_string(cpu) + "/topology/thread_siblings_list"));
+    topo.logical_cpus = static_cast<unsigned int>(online.size());
+    topo.physical_cores = static_cast<unsigned int>(cores.size());
+
+    for (unsigned int index = 0;; ++index) {
+        std::string const dir = root + "cpu0/cache/index" + std::to_string(index) + "/";
+        std::string const level = _read_sysfs(dir + "level");
+        if (level.empty())
+            break;
+        std::string const type = _read_sysfs(dir + "type");
+        std::size_t const size = _parse_size(_read_sysfs(dir + "size"));
+        if (level == "1" && type == "Data")
+            topo.caches.l1d = size;
+        else if (level == "2")
+            topo.caches.l2 = size;
+        else if (level == "3")
+            topo.caches.l3 = size;
+        if (std::size_t const line = _parse_size(_read_sysfs(dir + "coherency_line_size")); line != 0)
+            topo.caches.line_size = line;
+    }
+#endif
+    if (topo.logical_cpus == 0)
+        topo.logical_cpus = std::max(1U, std::thread::hardware_concurrency());
+    if (topo.physical_cores == 0)
+        topo.physical_cores = topo.logical_cpus;
+    topo.smt_width = std::max(1U, topo.logical_cpus / topo.physical_cores);
+    return topo;
+}
+
+} // namespace sync
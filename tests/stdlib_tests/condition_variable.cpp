@@ -0,0 +1,39 @@
+// condition_variable.cpp
+
+#include "../catch.hpp"
+#include "../../stdlib/condition_variable.hpp"
+#include "../../stdlib/thread.hpp"
+
+#include <chrono>
+
+TEST_CASE("sync::condition_variable::wait", "[condition_variable]") {
+    sync::mutex m;
+    sync::condition_variable cv;
+    bool ready{false};
+
+    sync::thread t{[&] {
+        sync::unique_lock lock{m};
+        cv.wait(lock, [&]{ return ready; });
+        CHECK(ready);
+    }};
+
+    {
+        sync::unique_lock lock{m};
+        ready = true;
+    }
+    cv.notify_one();
+    t.join();
+}
+
+TEST_CASE("sync::condition_variable::wait_for", "[condition_variable]") {
+    using namespace std::chrono;
+    using namespace std::chrono_literals;
+
+    sync::mutex m;
+    sync::condition_variable cv;
+    sync::unique_lock lock{m};
+
+    auto const start = steady_clock::now();
+    CHECK(!cv.wait_for(lock, 10ms, []{ return false; }));
+    CHECK(duration_cast<milliseconds>(steady_clock::now() - start).count() >= 10);
+}
@@ -68,8 +68,32 @@ void test_timed_mutex() {
     m.unlock();
 }
 
+template<class M>
+void test_mutex_contention() {
+    M m;
+    int count{0};
+    auto work = [&] {
+        for (int i{0}; i < 10000; ++i) {
+            m.lock();
+            ++count;
+            m.unlock();
+        }
+    };
+    sync::thread t1{work};
+    sync::thread t2{work};
+    sync::thread t3{work};
+    t1.join();
+    t2.join();
+    t3.join();
+    CHECK(count == 30000);
+}
+
 TEST_CASE("sync::mutex", "[mutex]") {
     test_mutex<sync::mutex>();
+    test_mutex_contention<sync::mutex>();
+#if SYNC_FUTEX
+    static_assert(sizeof(sync::mutex) == sizeof(std::uint32_t));
+#endif
 }
 
 TEST_CASE("sync::recursive_mutex", "[mutex]") {
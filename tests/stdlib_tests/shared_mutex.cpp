@@ -0,0 +1,128 @@
+// shared_mutex.cpp
+
+#include "../catch.hpp"
+#include "../../stdlib/shared_mutex.hpp"
+#include "../../stdlib/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+template<class M>
+void test_shared_mutex() {
+    M m;
+
+    m.lock_shared();
+    REQUIRE(m.try_lock_shared());
+    sync::thread t1([&] {
+        CHECK(!m.try_lock());
+        CHECK(m.try_lock_shared());
+        m.unlock_shared();
+    });
+    t1.join();
+    m.unlock_shared();
+    m.unlock_shared();
+
+    m.lock();
+    sync::thread t2([&] {
+        CHECK(!m.try_lock_shared());
+        CHECK(!m.try_lock());
+    });
+    t2.join();
+    m.unlock();
+
+    int value{0};
+    std::atomic<bool> negative{false};
+    std::vector<sync::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 1000; ++j) {
+                if (j % 4 == 0) {
+                    sync::unique_lock lock{m};
+                    ++value;
+                }
+                else {
+                    sync::shared_lock lock{m};
+                    if (value < 0)
+                        negative = true;
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    REQUIRE(value == 1000);
+    CHECK(!negative);
+}
+
+TEST_CASE("shared_mutex") {
+    test_shared_mutex<sync::shared_mutex>();
+}
+
+TEST_CASE("shared_timed_mutex") {
+    using namespace std::chrono_literals;
+
+    test_shared_mutex<sync::shared_timed_mutex>();
+
+    sync::shared_timed_mutex m;
+    m.lock();
+    sync::thread t([&] {
+        CHECK(!m.try_lock_shared_for(10ms));
+        CHECK(!m.try_lock_for(10ms));
+    });
+    t.join();
+    m.unlock();
+}
+
+TEST_CASE("upgrade_mutex") {
+    test_shared_mutex<sync::upgrade_mutex>();
+
+    sync::upgrade_mutex m;
+
+    SECTION("upgrade excludes writers and other upgraders, not readers") {
+        sync::upgrade_lock ul{m};
+        sync::thread t([&] {
+            CHECK(!m.try_lock());
+            CHECK(!m.try_lock_upgrade());
+            REQUIRE(m.try_lock_shared());
+            m.unlock_shared();
+        });
+        t.join();
+    }
+
+    SECTION("promotion waits for readers") {
+        std::atomic<bool> reading{true};
+        m.lock_shared();
+        sync::upgrade_lock ul{m};
+        CHECK(!ul.try_upgrade());
+        REQUIRE(ul.owns_lock());
+
+        sync::thread t([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            reading = false;
+            m.unlock_shared();
+        });
+        sync::unique_lock lock{ul.upgrade()};
+        CHECK(!reading);
+        CHECK(lock.owns_lock());
+        CHECK(!ul.owns_lock());
+        CHECK(!m.try_lock_shared());
+        t.join();
+    }
+
+    SECTION("downgrade lets readers back in") {
+        sync::unique_lock lock{m};
+        sync::upgrade_lock ul{std::move(lock)};
+        CHECK(!lock.owns_lock());
+        REQUIRE(ul.owns_lock());
+        sync::thread t([&] {
+            CHECK(!m.try_lock_upgrade());
+            REQUIRE(m.try_lock_shared());
+            m.unlock_shared();
+        });
+        t.join();
+
+        sync::unique_lock promoted{ul.try_upgrade()};
+        CHECK(promoted.owns_lock());
+    }
+}
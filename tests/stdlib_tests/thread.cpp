@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <functional>
+#include <system_error>
 
 void func(int& i) {
     ++i;
@@ -64,6 +65,31 @@ TEST_CASE("sync::thread::thread, [thread]") {
     }
 }
 
+TEST_CASE("sync::thread::attributes, [thread]") {
+    SECTION("stack size and name") {
+        bool executed{false};
+        sync::thread t{sync::thread::attributes{}.stack_size(256 * 1024).guard_size(4096).name("sync-test"),
+                       [&](int n) { executed = n == 1; }, 1};
+        t.join();
+        CHECK(executed);
+    }
+
+    SECTION("scheduling errors are reported") {
+        bool ran = false;
+        CHECK_THROWS_AS((sync::thread{sync::thread::attributes{}.fifo_priority(100000), [&] { ran = true; }}), std::system_error);
+        CHECK(!ran);
+    }
+
+    SECTION("jthread") {
+        bool stop_possible{false};
+        {
+            sync::jthread t{sync::thread::attributes{}.name("sync-jthread"),
+                            [&](sync::stop_token token) { stop_possible = token.stop_possible(); }};
+        }
+        CHECK(stop_possible);
+    }
+}
+
 TEST_CASE("sync::thread::get_id, [thread]") {
     SECTION("get_id") {
         sync::thread t1{[](){}};
@@ -95,9 +121,10 @@ TEST_CASE("sync::thread::swap, [thread]") {
     }
 }
 
-TEST_CASE("sync::thread::hardward_concurrency, [thread]") {
-    SECTION("hardward_concurrency") {
-        volatile auto con = sync::thread::hardward_concurrency();
+TEST_CASE("sync::thread::hardware_concurrency, [thread]") {
+    SECTION("hardware_concurrency") {
+        CHECK(sync::thread::hardware_concurrency() >= 1);
+        CHECK(sync::jthread::hardware_concurrency() == sync::thread::hardware_concurrency());
     }
 }
 
@@ -0,0 +1,117 @@
+// future.cpp
+
+#include "../catch.hpp"
+#include "../../sync/future.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct alignas(128) wide_value {
+    int v;
+};
+
+}
+
+TEST_CASE("sync::block_pool", "[future]") {
+    sync::block_pool pool;
+    void* const a = pool.allocate(40);
+    pool.deallocate(a, 40);
+    // a freed block is handed out again for any size of the same class
+    void* const b = pool.allocate(64);
+    CHECK(a == b);
+    pool.deallocate(b, 64);
+
+    void* const big = pool.allocate(4096);
+    CHECK(big != nullptr);
+    pool.deallocate(big, 4096);
+
+    void* const wide = pool.allocate(64, 128);
+    CHECK(reinterpret_cast<std::uintptr_t>(wide) % 128 == 0);
+    pool.deallocate(wide, 64, 128);
+}
+
+TEST_CASE("sync::block_pool moves blocks between threads", "[future]") {
+    sync::block_pool pool;
+    std::vector<void*> blocks(200);
+    std::thread producer{[&] {
+        for (auto& block : blocks)
+            block = pool.allocate(100);
+    }};
+    producer.join();
+    // freed here, most of them overflow this thread's cache into the shared list
+    std::set<void*> const freed(blocks.begin(), blocks.end());
+    for (void* block : blocks)
+        pool.deallocate(block, 100);
+
+    std::thread consumer{[&] {
+        for (auto& block : blocks)
+            block = nullptr;
+        for (std::size_t k = 0; k < 100; ++k)
+            blocks[k] = pool.allocate(128);
+    }};
+    consumer.join();
+    for (std::size_t k = 0; k < 100; ++k)
+        CHECK(freed.count(blocks[k]) == 1);
+    for (std::size_t k = 0; k < 100; ++k)
+        pool.deallocate(blocks[k], 128);
+}
+
+TEST_CASE("sync::future", "[future]") {
+    SECTION("value from another thread") {
+        sync::block_pool pool;
+        sync::promise<std::unique_ptr<int>> p{pool};
+        auto f = p.get_future();
+        std::thread t{[p = std::move(p)]() mutable { p.set_value(std::make_unique<int>(7)); }};
+        CHECK(*f.get() == 7);
+        CHECK(!f.valid());
+        t.join();
+    }
+
+    SECTION("void and exceptions") {
+        sync::promise<void> p;
+        auto f = p.get_future();
+        p.set_exception(std::make_exception_ptr(std::runtime_error{"boom"}));
+        CHECK(f.is_ready());
+        CHECK_THROWS_AS(f.get(), std::runtime_error);
+    }
+
+    SECTION("broken promise") {
+        sync::future<int> f;
+        {
+            sync::promise<int> p;
+            f = p.get_future();
+        }
+        CHECK_THROWS_AS(f.get(), std::future_error);
+    }
+
+    SECTION("over-aligned values") {
+        sync::block_pool pool;
+        sync::promise<wide_value> p{pool};
+        auto f = p.get_future();
+        p.set_value(wide_value{3});
+        wide_value const v = f.get();
+        CHECK(v.v == 3);
+    }
+
+    SECTION("shared state is recycled") {
+        sync::block_pool pool;
+        void* first = nullptr;
+        for (int i = 0; i < 3; ++i) {
+            sync::promise<int> p{pool};
+            auto f = p.get_future();
+            p.set_value(i);
+            CHECK(f.get() == i);
+            void* const block = pool.allocate(sizeof(sync::_future_state<int>));
+            if (first == nullptr)
+                first = block;
+            CHECK(block == first);
+            pool.deallocate(block, sizeof(sync::_future_state<int>));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+// lock_profiler.cpp
+
+#include "../catch.hpp"
+#include "../../sync/lock_profiler.hpp"
+#include "../../stdlib/thread.hpp"
+
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
+TEST_CASE("sync::profiled", "[lock_profiler]") {
+    SECTION("counts acquisitions and holds") {
+        sync::profiled<sync::mutex> m;
+        for (int i = 0; i < 10; ++i) {
+            sync::scoped_lock lock{m};
+        }
+        sync::lock_stats const stats = m.stats();
+        CHECK(stats.acquisitions == 10);
+        CHECK(stats.contended == 0);
+        std::uint64_t holds = 0;
+        for (auto n : stats.hold_histogram)
+            holds += n;
+        CHECK(holds == 10);
+        CHECK(stats.site.find("lock_profiler.cpp") != std::string::npos);
+    }
+
+    SECTION("recursive and timed mutexes") {
+        sync::profiled<sync::recursive_mutex> r;
+        r.lock();
+        r.lock();
+        r.unlock();
+        r.unlock();
+        CHECK(r.stats().acquisitions == 2);
+
+        sync::profiled<sync::timed_mutex> t;
+        CHECK(t.try_lock_for(std::chrono::milliseconds{1}));
+        t.unlock();
+        CHECK(t.stats().acquisitions == 1);
+    }
+
+    SECTION("contention and call sites") {
+        sync::profiled<sync::fast_mutex> m;
+        sync::profiled<sync::spinlock_mutex> quiet;
+        m.lock();
+        sync::thread waiter{[&] {
+            sync::profiled_lock_guard lock{m};
+        }};
+        sync::this_thread::sleep_for(std::chrono::milliseconds{20});
+        m.unlock();
+        waiter.join();
+
+        sync::lock_stats const stats = m.stats();
+        CHECK(stats.acquisitions == 2);
+        CHECK(stats.contended == 1);
+        CHECK(stats.wait_ns > 0);
+        REQUIRE(stats.call_sites.size() == 1);
+        CHECK(stats.call_sites.front().contended == 1);
+        // the guard's caller, not the profiler's header
+        CHECK(stats.call_sites.front().file.find("lock_profiler.cpp") != std::string::npos);
+
+        std::vector<sync::lock_stats> const all = sync::lock_profile();
+        REQUIRE(all.size() >= 2);
+        CHECK(all.front().wait_ns == stats.wait_ns);
+
+        sync::reset_lock_profile();
+        CHECK(m.stats().acquisitions == 0);
+    }
+
+    SECTION("profiled_if") {
+        static_assert(std::is_same_v<sync::profiled_if<sync::mutex, false>, sync::mutex>);
+        static_assert(std::is_same_v<sync::profiled_if<sync::mutex, true>, sync::profiled<sync::mutex>>);
+
+        sync::profiled_if<sync::mutex, false> plain;
+        {
+            sync::profiled_lock_guard lock{plain};
+        }
+        CHECK(plain.try_lock());
+        plain.unlock();
+    }
+
+    SECTION("shared locks") {
+        sync::profiled<sync::fast_shared_mutex> m;
+        m.lock_shared();
+        {
+            sync::profiled_shared_lock_guard lock{m};
+        }
+        m.unlock_shared();
+        m.lock();
+        m.unlock();
+        CHECK(m.stats().acquisitions == 3);
+    }
+}
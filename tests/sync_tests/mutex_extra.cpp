@@ -0,0 +1,264 @@
+// mutex_extra.cpp
+
+#include "../catch.hpp"
+#include "../../stdlib/thread.hpp"
+#include "../../sync/mutex_extra.hpp"
+
+#include <atomic>
+#include <type_traits>
+
+template<class M>
+void test_exclusive() {
+    M m;
+    m.lock();
+    sync::thread t1{[&] {
+        CHECK(!m.try_lock());
+    }};
+    t1.join();
+    m.unlock();
+    sync::thread t2{[&] {
+        REQUIRE(m.try_lock());
+        m.unlock();
+    }};
+    t2.join();
+}
+
+template<class M>
+void test_contention() {
+    M m;
+    int count{0};
+    auto work = [&] {
+        for (int i{0}; i < 10000; ++i) {
+            m.lock();
+            ++count;
+            m.unlock();
+        }
+    };
+    sync::thread t1{work};
+    sync::thread t2{work};
+    sync::thread t3{work};
+    sync::thread t4{work};
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    CHECK(count == 40000);
+}
+
+template<class M>
+void test_shared() {
+    M m;
+    m.lock_shared();
+    sync::thread reader{[&] {
+        REQUIRE(m.try_lock_shared());
+        CHECK(!m.try_lock());
+        m.unlock_shared();
+    }};
+    reader.join();
+    m.unlock_shared();
+
+    // writers keep the two halves equal, readers must never see them differ
+    long a{0};
+    long b{0};
+    std::atomic<bool> torn{false};
+    auto write = [&] {
+        for (int i{0}; i < 2000; ++i) {
+            m.lock();
+            ++a;
+            ++b;
+            m.unlock();
+        }
+    };
+    auto read = [&] {
+        for (int i{0}; i < 2000; ++i) {
+            m.lock_shared();
+            if (a != b)
+                torn = true;
+            m.unlock_shared();
+        }
+    };
+    sync::thread t1{write};
+    sync::thread t2{read};
+    sync::thread t3{write};
+    sync::thread t4{read};
+    t1.join();
+    t2.join();
+    t3.join();
+    t4.join();
+    CHECK(!torn);
+    CHECK(a == 4000);
+}
+
+TEST_CASE("sync::spinlock_mutex", "[mutex_extra]") {
+    test_exclusive<sync::spinlock_mutex>();
+    test_contention<sync::spinlock_mutex>();
+}
+
+TEST_CASE("sync::fast_mutex", "[mutex_extra]") {
+    test_exclusive<sync::fast_mutex>();
+    test_contention<sync::fast_mutex>();
+
+    // default construction stays implicit, only the spin budget constructor is explicit
+    struct guarded {
+        sync::fast_mutex    mutex;
+        int                 value;
+    };
+    guarded g{{}, 1};
+    sync::fast_mutex m = {};
+    sync::fast_mutex short_spin{10};
+    static_assert(!std::is_convertible_v<unsigned int, sync::fast_mutex>);
+    CHECK(g.mutex.try_lock());
+    CHECK(m.try_lock());
+    CHECK(short_spin.try_lock());
+    g.mutex.unlock();
+    m.unlock();
+    short_spin.unlock();
+}
+
+TEST_CASE("sync::mcs_mutex", "[mutex_extra]") {
+    test_exclusive<sync::mcs_mutex>();
+    test_contention<sync::mcs_mutex>();
+}
+
+TEST_CASE("sync::clh_mutex", "[mutex_extra]") {
+    test_exclusive<sync::clh_mutex>();
+    test_contention<sync::clh_mutex>();
+
+    // try_lock racing lock() and unlock(), which recycle nodes, must stay exclusive
+    sync::clh_mutex m;
+    int count{0};
+    auto work = [&] {
+        for (int i{0}; i < 5000; ++i) {
+            if (!m.try_lock())
+                m.lock();
+            ++count;
+            m.unlock();
+        }
+    };
+    sync::thread t1{work};
+    sync::thread t2{work};
+    sync::thread t3{work};
+    t1.join();
+    t2.join();
+    t3.join();
+    CHECK(count == 15000);
+}
+
+TEST_CASE("sync::fast_shared_mutex", "[mutex_extra]") {
+    test_exclusive<sync::fast_shared_mutex>();
+    test_contention<sync::fast_shared_mutex>();
+    test_shared<sync::fast_shared_mutex>();
+
+    // writers queue up back to back, a reader must still get its turns before they give up
+    sync::fast_shared_mutex m;
+    std::atomic<bool> done{false};
+    std::atomic<int> writers{2};
+    std::atomic<int> writes{0};
+    auto write = [&] {
+        for (int i{0}; i < 5000000 && !done.load(std::memory_order_relaxed); ++i) {
+            m.lock();
+            m.unlock();
+            writes.fetch_add(1, std::memory_order_relaxed);
+        }
+        --writers;
+    };
+    sync::thread w1{write};
+    sync::thread w2{write};
+    while (writes.load(std::memory_order_relaxed) == 0)
+        sync::this_thread::yield();
+    for (int i{0}; i < 500; ++i) {
+        m.lock_shared();
+        m.unlock_shared();
+    }
+    bool const writers_running = writers == 2;
+    done = true;
+    w1.join();
+    w2.join();
+    CHECK(writers_running);
+}
+
+TEST_CASE("sync::scalable_shared_mutex", "[mutex_extra]") {
+    test_exclusive<sync::scalable_shared_mutex>();
+    test_contention<sync::scalable_shared_mutex>();
+    test_shared<sync::scalable_shared_mutex>();
+}
+
+TEST_CASE("sync::stamped_mutex", "[mutex_extra]") {
+    test_exclusive<sync::stamped_mutex>();
+    test_contention<sync::stamped_mutex>();
+    test_shared<sync::stamped_mutex>();
+
+    sync::stamped_mutex m;
+
+    SECTION("stamps") {
+        auto const stamp = m.try_optimistic_read();
+        REQUIRE(stamp != 0);
+        CHECK(m.validate(stamp));
+        m.lock_shared();
+        CHECK(m.validate(stamp));
+        m.unlock_shared();
+        m.lock();
+        CHECK(m.try_optimistic_read() == 0);
+        CHECK(!m.validate(stamp));
+        m.unlock();
+        CHECK(!m.validate(stamp));
+        CHECK(!m.try_convert_to_shared(stamp));
+        CHECK(!m.try_convert_to_exclusive(stamp));
+
+        auto const next = m.try_optimistic_read();
+        REQUIRE(m.try_convert_to_shared(next));
+        CHECK(!m.try_lock());
+        m.unlock_shared();
+        REQUIRE(m.try_convert_to_exclusive(next));
+        CHECK(!m.validate(next));
+        m.unlock();
+    }
+
+    SECTION("validated optimistic reads are never torn") {
+        std::atomic<long> a{0};
+        std::atomic<long> b{0};
+        bool torn{false};
+        sync::thread writer{[&] {
+            for (int i{0}; i < 2000; ++i) {
+                m.lock();
+                a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                m.unlock();
+            }
+        }};
+        sync::thread reader{[&] {
+            for (int i{0}; i < 2000; ++i) {
+                auto const stamp = m.try_optimistic_read();
+                long const x = a.load(std::memory_order_relaxed);
+                long const y = b.load(std::memory_order_relaxed);
+                if (m.validate(stamp) && x != y)
+                    torn = true;
+            }
+        }};
+        writer.join();
+        reader.join();
+        CHECK(!torn);
+        CHECK(a == 2000);
+    }
+}
+
+TEST_CASE("sync::scoped_lock with queue locks", "[mutex_extra]") {
+    sync::mcs_mutex m0;
+    sync::clh_mutex m1;
+    {
+        sync::scoped_lock lock{m0, m1};
+        CHECK(!m0.try_lock());
+    }
+    sync::lock(m1, m0);
+    m0.unlock();
+    m1.unlock();
+    CHECK(m0.try_lock());
+    CHECK(m1.try_lock());
+    m0.unlock();
+    m1.unlock();
+}
+
+TEST_CASE("sync::ticket_mutex", "[mutex_extra]") {
+    test_exclusive<sync::ticket_mutex>();
+    test_contention<sync::ticket_mutex>();
+}
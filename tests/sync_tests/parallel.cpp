@@ -0,0 +1,83 @@
+// parallel.cpp
+
+#include "../catch.hpp"
+#include "../../sync/parallel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+template<class T>
+using pool_queue = sync::simple_blocking_queue<T, std::queue<T>>;
+
+template<class Pool>
+void test_parallel(Pool& pool) {
+    SECTION("parallel_for") {
+        std::vector<std::atomic_int> hits(1000);
+        sync::parallel_for(pool, 0, 1000, 0, [&](int i) { ++hits[static_cast<std::size_t>(i)]; });
+        for (auto const& h : hits)
+            CHECK(h == 1);
+    }
+
+    SECTION("parallel_for over size_t with a literal grain") {
+        std::vector<int> const values(500, 2);
+        std::atomic_int sum{0};
+        sync::parallel_for(pool, std::size_t{0}, values.size(), 0, [&](std::size_t i) { sum += values[i]; });
+        CHECK(sum == 1000);
+    }
+
+    SECTION("uneven work is all done") {
+        std::vector<std::atomic_int> hits(256);
+        sync::parallel_for(pool, 0, 256, 0, [&](int i) {
+            if (i < 8)
+                std::this_thread::sleep_for(std::chrono::milliseconds{2});
+            ++hits[static_cast<std::size_t>(i)];
+        });
+        for (auto const& h : hits)
+            CHECK(h == 1);
+    }
+
+    SECTION("exceptions reach the caller") {
+        CHECK_THROWS_AS(sync::parallel_for(pool, 0, 1000, 0, [](int i) {
+            if (i == 700)
+                throw std::runtime_error{"700"};
+        }), std::runtime_error);
+        CHECK_THROWS_AS((void)sync::parallel_reduce(pool, 0, 1000, 10, 0,
+            [](int i) { return i == 3 ? throw std::runtime_error{"3"}, i : i; },
+            [](int a, int b) { return a + b; }), std::runtime_error);
+    }
+
+    SECTION("parallel_reduce keeps the operand order") {
+        std::string const s = sync::parallel_reduce(pool, 0, 26, 3, std::string{},
+            [](int i) { return std::string(1, static_cast<char>('a' + i)); },
+            [](std::string a, std::string const& b) { return a + b; });
+        CHECK(s == "abcdefghijklmnopqrstuvwxyz");
+    }
+
+    SECTION("parallel_scan") {
+        std::vector<long> values(1001);
+        std::iota(values.begin(), values.end(), 1L);
+        std::vector<long> expected(values.size());
+        std::partial_sum(values.begin(), values.end(), expected.begin());
+        sync::parallel_scan(pool, values.begin(), values.end(), values.begin(), 64, 0L, std::plus<>{});
+        CHECK(values == expected);
+    }
+}
+
+TEST_CASE("sync::parallel algorithms", "[parallel]") {
+    SECTION("simple_thread_pool") {
+        sync::simple_thread_pool<pool_queue> pool{3};
+        test_parallel(pool);
+    }
+
+    SECTION("work_stealing_thread_pool") {
+        sync::work_stealing_thread_pool<pool_queue> pool{3};
+        test_parallel(pool);
+    }
+}
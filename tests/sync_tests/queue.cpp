@@ -0,0 +1,203 @@
+// queue.cpp
+
+#include "../catch.hpp"
+#include "../../stdlib/thread.hpp"
+#include "../../sync/queue.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+TEST_CASE("sync::simple_blocking_queue push_bulk", "[queue]") {
+    sync::simple_blocking_queue<int, std::queue<int>> q;
+    std::vector<int> const values{1, 2, 3, 4, 5};
+
+    std::atomic_int sum{0};
+    std::vector<sync::thread> consumers;
+    for (int i = 0; i < 2; ++i)
+        consumers.emplace_back([&] {
+            while (std::optional<int> v = q.pop())
+                sum += *v;
+        });
+
+    q.push_bulk(values.begin(), values.end());
+    while (!q.empty())
+        sync::this_thread::yield();
+    q.done();
+    for (auto& t : consumers)
+        t.join();
+    CHECK(sum == 15);
+}
+
+TEST_CASE("sync::lock_free_queue", "[queue]") {
+    SECTION("capacity") {
+        sync::lock_free_queue<int> q{5};
+        CHECK(q.capacity() == 8);
+        for (int i{0}; i < 8; ++i)
+            REQUIRE(q.try_push(i));
+        CHECK(q.full());
+        CHECK(!q.try_push(8));
+        for (int i{0}; i < 8; ++i)
+            CHECK(q.pop() == i);
+        CHECK(q.empty());
+        CHECK(!q.try_pop());
+    }
+
+    SECTION("move only") {
+        sync::lock_free_queue<std::unique_ptr<int>> q{2};
+        q.push(std::make_unique<int>(1));
+        REQUIRE(q.try_push(std::make_unique<int>(2)));
+        CHECK(*q.pop() == 1);
+        CHECK(*q.pop() == 2);
+    }
+
+    SECTION("producers and consumers") {
+        sync::lock_free_queue<int> q{4};
+        long sum1{0};
+        long sum2{0};
+        auto produce = [&] {
+            for (int i{1}; i <= 1000; ++i)
+                q.push(i);
+        };
+        sync::thread p1{produce};
+        sync::thread p2{produce};
+        sync::thread c1{[&] { for (int i{0}; i < 1000; ++i) sum1 += q.pop(); }};
+        sync::thread c2{[&] { for (int i{0}; i < 1000; ++i) sum2 += q.pop(); }};
+        p1.join();
+        p2.join();
+        c1.join();
+        c2.join();
+        CHECK(sum1 + sum2 == 2 * 500500);
+        CHECK(q.empty());
+    }
+}
+
+TEST_CASE("sync::spsc_queue", "[queue]") {
+    SECTION("single elements") {
+        sync::spsc_queue<std::unique_ptr<int>> q{2};
+        REQUIRE(q.try_push(std::make_unique<int>(1)));
+        REQUIRE(q.try_push(std::make_unique<int>(2)));
+        CHECK(!q.try_push(std::make_unique<int>(3)));
+        CHECK(*q.pop() == 1);
+        CHECK(**q.try_pop() == 2);
+        CHECK(!q.try_pop());
+    }
+
+    SECTION("bulk") {
+        sync::spsc_queue<int> q{8};
+        int in[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+        CHECK(q.push_n(in, 12) == 8);
+        int out[12] = {};
+        CHECK(q.pop_n(out, 5) == 5);
+        CHECK(q.push_n(in + 8, 4) == 4);
+        CHECK(q.pop_n(out + 5, 12) == 7);
+        for (int i{0}; i < 12; ++i)
+            CHECK(out[i] == i);
+    }
+
+    SECTION("producer and consumer") {
+        sync::spsc_queue<int> q{16};
+        long sum{0};
+        sync::thread producer{[&] {
+            int batch[5];
+            for (int i{1}; i <= 5000; i += 5) {
+                for (int j{0}; j < 5; ++j)
+                    batch[j] = i + j;
+                for (std::size_t done{0}; done < 5;)
+                    done += q.push_n(batch + done, 5 - done);
+            }
+        }};
+        for (int i{0}; i < 5000; ++i)
+            sum += q.pop();
+        producer.join();
+        CHECK(sum == 12502500);
+    }
+}
+
+struct message : sync::mpsc_node {
+    explicit message(int v) : value{v} {}
+    int value;
+};
+
+TEST_CASE("sync::intrusive_mpsc_queue", "[queue]") {
+    SECTION("fifo") {
+        sync::intrusive_mpsc_queue<message> q;
+        message m0{0}, m1{1}, m2{2};
+        CHECK(q.empty());
+        CHECK(q.try_pop() == nullptr);
+        q.push(&m0);
+        q.push(&m1);
+        CHECK(!q.empty());
+        CHECK(q.pop() == &m0);
+        q.push(&m2);
+        CHECK(q.pop() == &m1);
+        CHECK(q.try_pop() == &m2);
+        CHECK(q.try_pop() == nullptr);
+        CHECK(q.empty());
+    }
+
+    SECTION("producers") {
+        sync::intrusive_mpsc_queue<message> q;
+        std::vector<message> m1, m2;
+        for (int i{1}; i <= 1000; ++i) {
+            m1.emplace_back(i);
+            m2.emplace_back(i);
+        }
+        auto produce = [&](std::vector<message>& msgs) {
+            for (auto& m : msgs)
+                q.push(&m);
+        };
+        sync::thread p1{produce, std::ref(m1)};
+        sync::thread p2{produce, std::ref(m2)};
+        long sum{0};
+        for (int i{0}; i < 2000; ++i)
+            sum += q.pop()->value;
+        p1.join();
+        p2.join();
+        CHECK(sum == 2 * 500500);
+        CHECK(q.try_pop() == nullptr);
+    }
+}
+
+TEST_CASE("sync::work_stealing_deque", "[queue]") {
+    SECTION("owner is lifo, thieves are fifo") {
+        sync::work_stealing_deque<int> d{2};
+        for (int i{0}; i < 10; ++i)
+            d.push(i);
+        CHECK(d.size() == 10);
+        CHECK(*d.steal() == 0);
+        CHECK(*d.pop() == 9);
+        CHECK(*d.steal() == 1);
+        for (int i{8}; i >= 2; --i)
+            CHECK(*d.pop() == i);
+        CHECK(!d.pop());
+        CHECK(!d.steal());
+    }
+
+    SECTION("thieves") {
+        sync::work_stealing_deque<int> d;
+        std::atomic_long sum{0};
+        std::atomic_bool done{false};
+        auto thief = [&] {
+            while (!done.load() || !d.empty())
+                if (auto i = d.steal())
+                    sum += *i;
+        };
+        sync::thread t1{thief};
+        sync::thread t2{thief};
+        for (int i{1}; i <= 10000; ++i) {
+            d.push(i);
+            if (i % 3 == 0)
+                if (auto j = d.pop())
+                    sum += *j;
+        }
+        while (auto i = d.pop())
+            sum += *i;
+        done = true;
+        t1.join();
+        t2.join();
+        CHECK(sum == 50005000);
+    }
+}
@@ -0,0 +1,97 @@
+// seqlock.cpp
+
+#include "../catch.hpp"
+#include "../../stdlib/thread.hpp"
+#include "../../sync/seqlock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+struct quote {
+    long    bid;
+    long    ask;
+    double  mid;
+    char    venue;
+};
+
+template<class F>
+concept quote_modifier = requires (sync::seqlock<quote>& q, F f) { q.modify(f); };
+
+}
+
+TEST_CASE("sync::seqlock", "[seqlock]") {
+    SECTION("store and load") {
+        sync::seqlock<quote> q;
+        CHECK(q.load().bid == 0);
+        q.store({1, 3, 2.0, 'x'});
+        quote const v = q.load();
+        CHECK(v.bid == 1);
+        CHECK(v.ask == 3);
+        CHECK(v.mid == 2.0);
+        CHECK(v.venue == 'x');
+
+        q.modify([](quote& current) noexcept { ++current.bid; });
+        CHECK(q.load().bid == 2);
+        static_assert(!quote_modifier<decltype([](quote&) {})>, "modify() takes only noexcept functions");
+
+        sync::seqlock<char> c{'a'};
+        CHECK(c.load() == 'a');
+    }
+
+    SECTION("readers never see a torn value") {
+        sync::seqlock<quote> q;
+        std::atomic<bool> done{false};
+        std::atomic<bool> torn{false};
+        auto read = [&] {
+            while (!done.load(std::memory_order_relaxed)) {
+                quote const v = q.load();
+                if (v.ask != v.bid + 2 || v.mid != v.bid + 1.0)
+                    torn = true;
+            }
+        };
+        q.store({0, 2, 1.0, 'x'});
+        sync::thread r1{read};
+        sync::thread r2{read};
+        for (long i{1}; i <= 20000; ++i)
+            q.store({i, i + 2, i + 1.0, 'x'});
+        done = true;
+        r1.join();
+        r2.join();
+        CHECK(!torn);
+        CHECK(q.load().bid == 20000);
+    }
+
+    SECTION("load waits out a write in progress") {
+        using namespace std::chrono_literals;
+        sync::seqlock<quote> q{{1, 3, 2.0, 'x'}};
+        std::atomic<bool> writing{false};
+        std::atomic<bool> release{false};
+        std::atomic<bool> loaded{false};
+        quote seen{};
+        sync::thread writer{[&] {
+            q.modify([&](quote& v) noexcept {
+                writing = true;
+                while (!release)
+                    std::this_thread::sleep_for(1ms);
+                v = {5, 7, 6.0, 'y'};
+            });
+        }};
+        while (!writing)
+            std::this_thread::yield();
+        sync::thread reader{[&] {
+            seen = q.load();
+            loaded = true;
+        }};
+        std::this_thread::sleep_for(20ms);
+        CHECK(!loaded);
+        release = true;
+        writer.join();
+        reader.join();
+        CHECK(loaded);
+        CHECK(seen.bid == 5);
+        CHECK(seen.venue == 'y');
+    }
+}
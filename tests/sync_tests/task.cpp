@@ -0,0 +1,47 @@
+// task.cpp
+
+#include "../catch.hpp"
+#include "../../sync/task.hpp"
+
+#include <array>
+#include <memory>
+
+TEST_CASE("sync::task", "[task]") {
+    SECTION("empty") {
+        sync::task t;
+        CHECK(!t);
+    }
+
+    SECTION("inline move only callable") {
+        int n{0};
+        auto p = std::make_unique<int>(2);
+        sync::task t{[&n, p = std::move(p)] { n += *p; }};
+        REQUIRE(t);
+        sync::task moved{std::move(t)};
+        CHECK(!t);
+        moved();
+        CHECK(n == 2);
+    }
+
+    SECTION("large callable") {
+        int n{0};
+        std::array<int, 32> values{};
+        values.fill(1);
+        sync::task t{[&n, values] { for (int v : values) n += v; }};
+        sync::task other;
+        other = std::move(t);
+        other();
+        CHECK(n == 32);
+    }
+
+    SECTION("destroys the callable") {
+        auto p = std::make_shared<int>(0);
+        {
+            sync::task t{[p] {}};
+            CHECK(p.use_count() == 2);
+        }
+        CHECK(p.use_count() == 1);
+    }
+
+    static_assert(sizeof(sync::task) <= 64);
+}
@@ -0,0 +1,260 @@
+// thread_pool.cpp
+
+#include "../catch.hpp"
+#include "../../sync/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <queue>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if SYNC_LINUX
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+template<class T>
+using pool_queue = sync::simple_blocking_queue<T, std::queue<T>>;
+
+template<class Pool>
+long fib(Pool& pool, int n) {
+    if (n < 2)
+        return n;
+    long a{0};
+    long b{0};
+    sync::task_group group{pool};
+    group.fork([&] { a = fib(pool, n - 1); });
+    b = fib(pool, n - 2);
+    group.join();
+    return a + b;
+}
+
+// a task whose copy throws for index 5, so post_bulk fails half way through the range
+struct copy_fails_at_5 {
+    copy_fails_at_5(std::atomic_int* ran, int k)
+        : ran_{ran}
+        , k_{k}
+    {}
+
+    copy_fails_at_5(copy_fails_at_5 const& other)
+        : ran_{other.ran_}
+        , k_{other.k_}
+    {
+        if (k_ == 5)
+            throw std::runtime_error{"copy"};
+    }
+
+    copy_fails_at_5(copy_fails_at_5&&) noexcept = default;
+
+    void operator()() const {
+        ++*ran_;
+    }
+
+    std::atomic_int*    ran_;
+    int                 k_;
+};
+
+template<class Pool>
+void test_pool() {
+    SECTION("post_task") {
+        Pool pool{2};
+        auto a = pool.post_task([](int x) { return x * 2; }, 21);
+        auto b = pool.post_task(sync::pooled, [](int x) { return x + 1; }, 41);
+        CHECK(a.get() == 42);
+        CHECK(b.get() == 42);
+    }
+
+    SECTION("post_n and wait_idle") {
+        Pool pool{3};
+        std::atomic_int sum{0};
+        pool.post_n(100, [&](std::size_t k) { sum += static_cast<int>(k); });
+        pool.wait_idle();
+        CHECK(sum == 4950);
+    }
+
+    SECTION("post_bulk failing part way leaves the pool usable") {
+        Pool pool{2};
+        std::atomic_int ran{0};
+        std::vector<copy_fails_at_5> tasks;
+        for (int k = 0; k < 10; ++k)
+            tasks.emplace_back(&ran, k);
+        CHECK_THROWS_AS(pool.post_bulk(tasks.begin(), tasks.end()), std::runtime_error);
+        // only the tasks before the failing one were queued, and wait_idle must not count the rest
+        pool.wait_idle();
+        CHECK(ran == 5);
+    }
+
+    SECTION("destructor drains") {
+        std::atomic_int count{0};
+        {
+            Pool pool{2};
+            for (int i = 0; i < 50; ++i)
+                pool.post_work([&] { ++count; });
+        }
+        CHECK(count == 50);
+    }
+
+    SECTION("recursive fork join with every worker joining") {
+        Pool pool{2};
+        std::vector<std::future<long>> results;
+        for (int i = 0; i < 4; ++i)
+            results.push_back(pool.post_task([&pool] { return fib(pool, 16); }));
+        for (auto& result : results)
+            CHECK(result.get() == 987);
+        CHECK(fib(pool, 18) == 2584);
+    }
+
+    SECTION("task_group rethrows a child's exception") {
+        Pool pool{2};
+        std::atomic_int count{0};
+        sync::task_group group{pool};
+        group.fork([] { throw std::runtime_error{"child"}; });
+        for (int i = 0; i < 10; ++i)
+            group.fork([&] { ++count; });
+        CHECK_THROWS_AS(group.join(), std::runtime_error);
+        CHECK(count == 10);
+        group.fork([&] { ++count; });
+        CHECK_NOTHROW(group.join());
+        CHECK(count == 11);
+    }
+
+    SECTION("shutdown cancel") {
+        std::atomic_int count{0};
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        Pool pool{1};
+        pool.post_work([opened] { opened.wait(); });
+        auto dropped = pool.post_task([&] { ++count; });
+        std::thread opener{[&] {
+            // let the blocked task go only once stop has been requested
+            while (!pool.get_stop_token().stop_requested())
+                std::this_thread::yield();
+            gate.set_value();
+        }};
+        pool.shutdown(sync::shutdown_mode::cancel);
+        opener.join();
+        CHECK(count == 0);
+        CHECK_THROWS_AS(dropped.get(), std::future_error);
+    }
+}
+
+template<class Pool>
+void test_pinned_pool() {
+    std::vector<unsigned int> const cpus = sync::numa_ordered_cpus();
+    REQUIRE(!cpus.empty());
+    sync::pool_options options = sync::pool_options::with_threads(3);
+    options.cpus = cpus;
+    Pool pool{options};
+    CHECK(pool.size() == 3);
+    std::atomic_int count{0};
+    pool.post_n(64, [&](std::size_t) { ++count; });
+    pool.wait_idle();
+    CHECK(count == 64);
+}
+
+// A worker after the first cannot be created: the address space limit leaves room for a
+// single worker stack. The constructor has to stop the started worker and throw instead of
+// terminating on a joinable thread.
+template<class Pool>
+void test_failed_start() {
+#if SYNC_LINUX
+    constexpr rlim_t stack = rlim_t{1} << 30;
+    long pages{0};
+    std::ifstream{"/proc/self/statm"} >> pages;
+    REQUIRE(pages > 0);
+    rlimit old{};
+    REQUIRE(getrlimit(RLIMIT_AS, &old) == 0);
+    rlimit tight = old;
+    tight.rlim_cur = static_cast<rlim_t>(pages) * static_cast<rlim_t>(sysconf(_SC_PAGESIZE)) + stack + stack / 2;
+    if (old.rlim_cur != RLIM_INFINITY && old.rlim_cur <= tight.rlim_cur)
+        return;
+
+    sync::pool_options options = sync::pool_options::with_threads(4);
+    options.attributes.stack_size(stack);
+    bool failed{false};
+    REQUIRE(setrlimit(RLIMIT_AS, &tight) == 0);
+    try {
+        Pool pool{options};
+    }
+    catch (std::system_error const&) {
+        failed = true;
+    }
+    REQUIRE(setrlimit(RLIMIT_AS, &old) == 0);
+    CHECK(failed);
+#endif
+}
+
+TEST_CASE("sync::simple_thread_pool", "[thread_pool]") {
+    test_pool<sync::simple_thread_pool<pool_queue>>();
+    test_pinned_pool<sync::simple_thread_pool<pool_queue>>();
+    test_failed_start<sync::simple_thread_pool<pool_queue>>();
+}
+
+// post_bulk from outside the pool hands the batch out in shares over the worker inboxes;
+// which worker ends up running what is the scheduler's business, all of it must run
+void test_bulk_spread() {
+    using Pool = sync::work_stealing_thread_pool<pool_queue>;
+    Pool pool{3};
+    std::atomic_int held{0};
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    // park every worker on a blocking task so the whole batch is queued before anything runs
+    pool.post_n(pool.size(), [&](std::size_t) {
+        ++held;
+        opened.wait();
+    });
+    while (held != static_cast<int>(pool.size()))
+        std::this_thread::yield();
+
+    std::vector<std::atomic_int> ran(4 * pool.size());
+    pool.post_n(ran.size(), [&](std::size_t k) { ++ran[k]; });
+    gate.set_value();
+    pool.wait_idle();
+    for (auto const& r : ran)
+        CHECK(r == 1);
+}
+
+// idle workers spin briefly and then sleep, work posted afterwards must wake one of them
+void test_parked_workers() {
+    using namespace std::chrono_literals;
+    using Pool = sync::work_stealing_thread_pool<pool_queue>;
+    Pool pool{2};
+
+    SECTION("posting wakes a parked worker") {
+        std::this_thread::sleep_for(50ms);
+        auto result = pool.post_task([] { return 42; });
+        REQUIRE(result.wait_for(1s) == std::future_status::ready);
+        CHECK(result.get() == 42);
+
+        std::this_thread::sleep_for(50ms);
+        std::atomic_int count{0};
+        pool.post_n(8, [&](std::size_t) { ++count; });
+        pool.wait_idle();
+        CHECK(count == 8);
+    }
+
+    SECTION("wait_idle with every worker parked") {
+        std::this_thread::sleep_for(50ms);
+        pool.wait_idle();
+        CHECK(pool.run_pending_task() == false);
+    }
+
+    SECTION("shutdown with every worker parked") {
+        std::this_thread::sleep_for(50ms);
+        pool.shutdown();
+        CHECK(pool.get_stop_token().stop_requested());
+    }
+}
+
+TEST_CASE("sync::work_stealing_thread_pool", "[thread_pool]") {
+    test_pool<sync::work_stealing_thread_pool<pool_queue>>();
+    test_pinned_pool<sync::work_stealing_thread_pool<pool_queue>>();
+    test_failed_start<sync::work_stealing_thread_pool<pool_queue>>();
+    test_bulk_spread();
+    test_parked_workers();
+}
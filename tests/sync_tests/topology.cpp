@@ -0,0 +1,34 @@
+// topology.cpp
+
+#include "../catch.hpp"
+#include "../../sync/topology.hpp"
+
+#include <vector>
+
+TEST_CASE("sync::numa_nodes", "[topology]") {
+    SECTION("cpu list format") {
+        using cpus = std::vector<unsigned int>;
+        CHECK(sync::_parse_cpu_list("") == cpus{});
+        CHECK(sync::_parse_cpu_list("3") == cpus{3});
+        CHECK(sync::_parse_cpu_list("0-2,5,7-8") == cpus{0, 1, 2, 5, 7, 8});
+    }
+
+    SECTION("every node has cpus") {
+        auto const nodes = sync::numa_nodes();
+        REQUIRE(!nodes.empty());
+        for (auto const& node : nodes) {
+            CHECK(!node.cpus.empty());
+            CHECK(sync::numa_node_of(nodes, node.cpus.front()) == node.id);
+        }
+    }
+}
+
+TEST_CASE("sync::topology", "[topology]") {
+    sync::cpu_topology const topo = sync::topology();
+    CHECK(topo.usable_cpus >= 1);
+    CHECK(topo.usable_cpus <= topo.logical_cpus);
+    CHECK(topo.physical_cores * topo.smt_width <= topo.logical_cpus);
+    CHECK(topo.caches.line_size != 0);
+    CHECK(!topo.nodes.empty());
+    CHECK(sync::_parse_size("48K") == 48 * 1024);
+}